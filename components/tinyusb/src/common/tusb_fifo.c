@@ -55,6 +55,28 @@ TU_ATTR_ALWAYS_INLINE static inline void _ff_unlock(osal_mutex_t mutex)
 
 #endif
 
+// Read/write path locks. In single producer/single consumer mode the indices are
+// the only state shared between both sides, therefore no mutex is needed.
+#define _ff_lock_wr(_f)     _ff_lock((_f)->spsc ? NULL : (_f)->mutex_wr)
+#define _ff_unlock_wr(_f)   _ff_unlock((_f)->spsc ? NULL : (_f)->mutex_wr)
+#define _ff_lock_rd(_f)     _ff_lock((_f)->spsc ? NULL : (_f)->mutex_rd)
+#define _ff_unlock_rd(_f)   _ff_unlock((_f)->spsc ? NULL : (_f)->mutex_rd)
+
+// Index hand-over between writer and reader: an index is stored with release
+// after the data has been copied and loaded with acquire before the data is
+// accessed, so the other side never sees an index ahead of its data on weakly
+// ordered or multi-core MCUs. Write and read mutexes are separate and do not
+// provide this ordering either.
+#if defined(__GNUC__) || defined(__clang__)
+  #define TU_FIFO_ATOMIC_INDEX    1
+  #define _ff_idx_load(_p)        __atomic_load_n((_p), __ATOMIC_ACQUIRE)
+  #define _ff_idx_store(_p, _v)   __atomic_store_n((_p), (_v), __ATOMIC_RELEASE)
+#else
+  #define TU_FIFO_ATOMIC_INDEX    0
+  #define _ff_idx_load(_p)        (*(_p))
+  #define _ff_idx_store(_p, _v)   (*(_p) = (_v))
+#endif
+
 /** \enum tu_fifo_copy_mode_t
  * \brief Write modes intended to allow special read and write functions to be able to
  *        copy data to and from USB hardware FIFOs as needed for e.g. STM32s and others
@@ -74,6 +96,10 @@ bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_si
   // only if overflow happens once (important for unsupervised DMA applications)
   if (depth > 0x8000) return false;
 
+  // SPSC mode survives re-configuration but can't be combined with overwriting,
+  // same rule as tu_fifo_set_overwritable() and tu_fifo_set_spsc()
+  if (overwritable && f->spsc) return false;
+
   _ff_lock(f->mutex_wr);
   _ff_lock(f->mutex_rd);
 
@@ -104,10 +130,21 @@ static void _ff_push_const_addr(uint8_t * ff_buf, const void * app_buf, uint16_t
 
   // Reading full available 32 bit words from const app address
   uint16_t full_words = len >> 2;
-  while(full_words--)
+  if ( ((uintptr_t) ff_buf & 0x03) == 0 )
   {
-    tu_unaligned_write32(ff_buf, *reg_rx);
-    ff_buf += 4;
+    // Word aligned destination: plain 32 bit stores, tu_unaligned_write32() is
+    // byte-wise on strict alignment architectures
+    uint32_t * ff_buf32 = (uint32_t *) (void *) ff_buf;
+    while(full_words--) *ff_buf32++ = *reg_rx;
+    ff_buf = (uint8_t *) ff_buf32;
+  }
+  else
+  {
+    while(full_words--)
+    {
+      tu_unaligned_write32(ff_buf, *reg_rx);
+      ff_buf += 4;
+    }
   }
 
   // Read the remaining 1-3 bytes from const app address
@@ -127,10 +164,20 @@ static void _ff_pull_const_addr(void * app_buf, const uint8_t * ff_buf, uint16_t
 
   // Write full available 32 bit words to const address
   uint16_t full_words = len >> 2;
-  while(full_words--)
+  if ( ((uintptr_t) ff_buf & 0x03) == 0 )
   {
-    *reg_tx = tu_unaligned_read32(ff_buf);
-    ff_buf += 4;
+    // Word aligned source: plain 32 bit loads
+    uint32_t const * ff_buf32 = (uint32_t const *) (void const *) ff_buf;
+    while(full_words--) *reg_tx = *ff_buf32++;
+    ff_buf = (uint8_t const *) ff_buf32;
+  }
+  else
+  {
+    while(full_words--)
+    {
+      *reg_tx = tu_unaligned_read32(ff_buf);
+      ff_buf += 4;
+    }
   }
 
   // Write the remaining 1-3 bytes into const address
@@ -148,6 +195,13 @@ static void _ff_pull_const_addr(void * app_buf, const uint8_t * ff_buf, uint16_t
 // send one item to fifo WITHOUT updating write pointer
 static inline void _ff_push(tu_fifo_t* f, void const * app_buf, uint16_t rel)
 {
+  // byte fifo (CDC, MIDI, vendor) is the common case, skip the memcpy() call
+  if ( f->item_size == 1 )
+  {
+    f->buffer[rel] = *(uint8_t const*) app_buf;
+    return;
+  }
+
   memcpy(f->buffer + (rel * f->item_size), app_buf, f->item_size);
 }
 
@@ -236,6 +290,12 @@ static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t
 // get one item from fifo WITHOUT updating read pointer
 static inline void _ff_pull(tu_fifo_t* f, void * app_buf, uint16_t rel)
 {
+  if ( f->item_size == 1 )
+  {
+    *(uint8_t*) app_buf = f->buffer[rel];
+    return;
+  }
+
   memcpy(app_buf, f->buffer + (rel * f->item_size), f->item_size);
 }
 
@@ -355,17 +415,15 @@ uint16_t _ff_remaining(uint16_t depth, uint16_t wr_idx, uint16_t rd_idx)
 // "absolute" index is only in the range of [0..2*depth)
 static uint16_t advance_index(uint16_t depth, uint16_t idx, uint16_t offset)
 {
-  // We limit the index space of p such that a correct wrap around happens
-  // Check for a wrap around or if we are in unused index space - This has to be checked first!!
-  // We are exploiting the wrap around to the correct index
-  uint16_t new_idx = (uint16_t) (idx + offset);
-  if ( (idx > new_idx) || (new_idx >= 2*depth) )
-  {
-    uint16_t const non_used_index_space = (uint16_t) (UINT16_MAX - (2*depth-1));
-    new_idx = (uint16_t) (new_idx + non_used_index_space);
-  }
-
-  return new_idx;
+  // idx is in [0..2*depth) and offset at most 2*depth, so a single conditional
+  // subtract is enough. Computing in 32 bit avoids the 16 bit wrap around and the
+  // unused index space correction, which also covers depth = 0x8000. This is as
+  // cheap as masking a power of two depth and works for any depth.
+  uint32_t new_idx = (uint32_t) idx + offset;
+  uint32_t const index_space = 2u*depth;
+  if ( new_idx >= index_space ) new_idx -= index_space;
+
+  return (uint16_t) new_idx;
 }
 
 #if 0 // not used but
@@ -390,9 +448,8 @@ static uint16_t backward_index(uint16_t depth, uint16_t idx, uint16_t offset)
 TU_ATTR_ALWAYS_INLINE static inline
 uint16_t idx2ptr(uint16_t depth, uint16_t idx)
 {
-  // Only run at most 3 times since index is limit in the range of [0..2*depth)
-  while ( idx >= depth ) idx -= depth;
-  return idx;
+  // idx is always in the range of [0..2*depth), a single compare is enough
+  return (idx >= depth) ? (uint16_t) (idx - depth) : idx;
 }
 
 // Works on local copies of w
@@ -410,7 +467,7 @@ uint16_t _ff_correct_read_index(tu_fifo_t* f, uint16_t wr_idx)
     rd_idx = wr_idx + f->depth;
   }
 
-  f->rd_idx = rd_idx;
+  _ff_idx_store(&f->rd_idx, rd_idx);
 
   return rd_idx;
 }
@@ -470,10 +527,10 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
 {
   if ( n == 0 ) return 0;
 
-  _ff_lock(f->mutex_wr);
+  _ff_lock_wr(f);
 
   uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  uint16_t rd_idx = _ff_idx_load(&f->rd_idx);
 
   uint8_t const* buf8 = (uint8_t const*) data;
 
@@ -543,28 +600,28 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
     _ff_push_n(f, buf8, n, wr_ptr, copy_mode);
 
     // Advance index
-    f->wr_idx = advance_index(f->depth, wr_idx, n);
+    _ff_idx_store(&f->wr_idx, advance_index(f->depth, wr_idx, n));
 
     TU_LOG(TU_FIFO_DBG, "\tnew_wr = %u\r\n", f->wr_idx);
   }
 
-  _ff_unlock(f->mutex_wr);
+  _ff_unlock_wr(f);
 
   return n;
 }
 
 static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo_copy_mode_t copy_mode)
 {
-  _ff_lock(f->mutex_rd);
+  _ff_lock_rd(f);
 
   // Peek the data
   // f->rd_idx might get modified in case of an overflow so we can not use a local variable
-  n = _tu_fifo_peek_n(f, buffer, n, f->wr_idx, f->rd_idx, copy_mode);
+  n = _tu_fifo_peek_n(f, buffer, n, _ff_idx_load(&f->wr_idx), f->rd_idx, copy_mode);
 
   // Advance read pointer
-  f->rd_idx = advance_index(f->depth, f->rd_idx, n);
+  _ff_idx_store(&f->rd_idx, advance_index(f->depth, f->rd_idx, n));
 
-  _ff_unlock(f->mutex_rd);
+  _ff_unlock_rd(f);
   return n;
 }
 
@@ -589,7 +646,7 @@ static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo
 /******************************************************************************/
 uint16_t tu_fifo_count(tu_fifo_t* f)
 {
-  return tu_min16(_ff_count(f->depth, f->wr_idx, f->rd_idx), f->depth);
+  return tu_min16(_ff_count(f->depth, _ff_idx_load(&f->wr_idx), _ff_idx_load(&f->rd_idx)), f->depth);
 }
 
 /******************************************************************************/
@@ -607,7 +664,7 @@ uint16_t tu_fifo_count(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_empty(tu_fifo_t* f)
 {
-  return f->wr_idx == f->rd_idx;
+  return _ff_idx_load(&f->wr_idx) == _ff_idx_load(&f->rd_idx);
 }
 
 /******************************************************************************/
@@ -625,7 +682,7 @@ bool tu_fifo_empty(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_full(tu_fifo_t* f)
 {
-  return _ff_count(f->depth, f->wr_idx, f->rd_idx) >= f->depth;
+  return _ff_count(f->depth, _ff_idx_load(&f->wr_idx), _ff_idx_load(&f->rd_idx)) >= f->depth;
 }
 
 /******************************************************************************/
@@ -643,7 +700,7 @@ bool tu_fifo_full(tu_fifo_t* f)
 /******************************************************************************/
 uint16_t tu_fifo_remaining(tu_fifo_t* f)
 {
-  return _ff_remaining(f->depth, f->wr_idx, f->rd_idx);
+  return _ff_remaining(f->depth, _ff_idx_load(&f->wr_idx), _ff_idx_load(&f->rd_idx));
 }
 
 /******************************************************************************/
@@ -669,15 +726,15 @@ uint16_t tu_fifo_remaining(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_overflowed(tu_fifo_t* f)
 {
-  return _ff_count(f->depth, f->wr_idx, f->rd_idx) > f->depth;
+  return _ff_count(f->depth, _ff_idx_load(&f->wr_idx), _ff_idx_load(&f->rd_idx)) > f->depth;
 }
 
 // Only use in case tu_fifo_overflow() returned true!
 void tu_fifo_correct_read_pointer(tu_fifo_t* f)
 {
-  _ff_lock(f->mutex_rd);
-  _ff_correct_read_index(f, f->wr_idx);
-  _ff_unlock(f->mutex_rd);
+  _ff_lock_rd(f);
+  _ff_correct_read_index(f, _ff_idx_load(&f->wr_idx));
+  _ff_unlock_rd(f);
 }
 
 /******************************************************************************/
@@ -698,16 +755,16 @@ void tu_fifo_correct_read_pointer(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_read(tu_fifo_t* f, void * buffer)
 {
-  _ff_lock(f->mutex_rd);
+  _ff_lock_rd(f);
 
   // Peek the data
   // f->rd_idx might get modified in case of an overflow so we can not use a local variable
-  bool ret = _tu_fifo_peek(f, buffer, f->wr_idx, f->rd_idx);
+  bool ret = _tu_fifo_peek(f, buffer, _ff_idx_load(&f->wr_idx), f->rd_idx);
 
   // Advance pointer
-  f->rd_idx = advance_index(f->depth, f->rd_idx, ret);
+  _ff_idx_store(&f->rd_idx, advance_index(f->depth, f->rd_idx, ret));
 
-  _ff_unlock(f->mutex_rd);
+  _ff_unlock_rd(f);
   return ret;
 }
 
@@ -771,9 +828,9 @@ uint16_t tu_fifo_read_n_const_addr_full_words(tu_fifo_t* f, void * buffer, uint1
 /******************************************************************************/
 bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 {
-  _ff_lock(f->mutex_rd);
-  bool ret = _tu_fifo_peek(f, p_buffer, f->wr_idx, f->rd_idx);
-  _ff_unlock(f->mutex_rd);
+  _ff_lock_rd(f);
+  bool ret = _tu_fifo_peek(f, p_buffer, _ff_idx_load(&f->wr_idx), f->rd_idx);
+  _ff_unlock_rd(f);
   return ret;
 }
 
@@ -794,9 +851,9 @@ bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 /******************************************************************************/
 uint16_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n)
 {
-  _ff_lock(f->mutex_rd);
-  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, f->wr_idx, f->rd_idx, TU_FIFO_COPY_INC);
-  _ff_unlock(f->mutex_rd);
+  _ff_lock_rd(f);
+  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, _ff_idx_load(&f->wr_idx), f->rd_idx, TU_FIFO_COPY_INC);
+  _ff_unlock_rd(f);
   return ret;
 }
 
@@ -818,12 +875,12 @@ uint16_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n)
 /******************************************************************************/
 bool tu_fifo_write(tu_fifo_t* f, const void * data)
 {
-  _ff_lock(f->mutex_wr);
+  _ff_lock_wr(f);
 
   bool ret;
   uint16_t const wr_idx = f->wr_idx;
 
-  if ( tu_fifo_full(f) && !f->overwritable )
+  if ( !f->overwritable && _ff_count(f->depth, wr_idx, _ff_idx_load(&f->rd_idx)) >= f->depth )
   {
     ret = false;
   }else
@@ -834,12 +891,12 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
     _ff_push(f, data, wr_ptr);
 
     // Advance pointer
-    f->wr_idx = advance_index(f->depth, wr_idx, 1);
+    _ff_idx_store(&f->wr_idx, advance_index(f->depth, wr_idx, 1));
 
     ret = true;
   }
 
-  _ff_unlock(f->mutex_wr);
+  _ff_unlock_wr(f);
 
   return ret;
 }
@@ -921,6 +978,11 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable) {
     return true;
   }
 
+  // Overwriting moves the read side from within write(), not possible without mutexes
+  if (overwritable && f->spsc) {
+    return false;
+  }
+
   _ff_lock(f->mutex_wr);
   _ff_lock(f->mutex_rd);
 
@@ -932,6 +994,42 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable) {
   return true;
 }
 
+/******************************************************************************/
+/*!
+    @brief Change the fifo to single producer/single consumer (SPSC) mode
+
+    In SPSC mode the write and read mutexes are bypassed: write functions must
+    only be called from one context (thread, ISR or core) and read functions
+    from one other context. Both sides synchronize through the acquire/release
+    ordered write and read indices only, which avoids mutex contention when the
+    producer and the consumer run on different cores.
+    Not available for overwritable fifos since an overflow moves the read side
+    from within the write functions. Only change the mode while the fifo is idle.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  spsc
+                SPSC mode the fifo is set to
+
+    @returns false if SPSC mode is not supported for this fifo or compiler
+ */
+/******************************************************************************/
+bool tu_fifo_set_spsc(tu_fifo_t *f, bool spsc) {
+  if (spsc && (f->overwritable || !TU_FIFO_ATOMIC_INDEX)) {
+    return false;
+  }
+
+  _ff_lock(f->mutex_wr);
+  _ff_lock(f->mutex_rd);
+
+  f->spsc = spsc;
+
+  _ff_unlock(f->mutex_wr);
+  _ff_unlock(f->mutex_rd);
+
+  return true;
+}
+
 /******************************************************************************/
 /*!
     @brief Advance write pointer - intended to be used in combination with DMA.
@@ -950,7 +1048,7 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable) {
 /******************************************************************************/
 void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
 {
-  f->wr_idx = advance_index(f->depth, f->wr_idx, n);
+  _ff_idx_store(&f->wr_idx, advance_index(f->depth, f->wr_idx, n));
 }
 
 /******************************************************************************/
@@ -971,7 +1069,7 @@ void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
 /******************************************************************************/
 void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 {
-  f->rd_idx = advance_index(f->depth, f->rd_idx, n);
+  _ff_idx_store(&f->rd_idx, advance_index(f->depth, f->rd_idx, n));
 }
 
 /******************************************************************************/
@@ -992,7 +1090,7 @@ void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
   // Operate on temporary values in case they change in between
-  uint16_t wr_idx = f->wr_idx;
+  uint16_t wr_idx = _ff_idx_load(&f->wr_idx);
   uint16_t rd_idx = f->rd_idx;
 
   uint16_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
@@ -1000,9 +1098,9 @@ void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
   // Check overflow and correct if required - may happen in case a DMA wrote too fast
   if (cnt > f->depth)
   {
-    _ff_lock(f->mutex_rd);
+    _ff_lock_rd(f);
     rd_idx = _ff_correct_read_index(f, wr_idx);
-    _ff_unlock(f->mutex_rd);
+    _ff_unlock_rd(f);
 
     cnt = f->depth;
   }
@@ -1060,7 +1158,7 @@ void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
   uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  uint16_t rd_idx = _ff_idx_load(&f->rd_idx);
   uint16_t remain = _ff_remaining(f->depth, wr_idx, rd_idx);
 
   if (remain == 0)
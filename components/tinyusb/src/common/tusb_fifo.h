@@ -40,6 +40,9 @@ extern "C" {
 // Also, this FIFO is ready to be used in combination with a DMA as the write and
 // read pointers can be updated from within a DMA ISR. Overflows are detectable
 // within a certain number (see tu_fifo_overflow()).
+// Write and read indices are published with release/acquire ordering, so with
+// exactly one producer and one consumer the FIFO can also be used lock-free from
+// different cores, see tu_fifo_set_spsc().
 
 #include "common/tusb_common.h"
 #include "osal/osal.h"
@@ -115,6 +118,8 @@ typedef struct {
   volatile uint16_t wr_idx ; // write index
   volatile uint16_t rd_idx ; // read index
 
+  bool spsc                ; // single producer/single consumer: mutexes are bypassed
+
 #if OSAL_MUTEX_REQUIRED
   osal_mutex_t mutex_wr;
   osal_mutex_t mutex_rd;
@@ -141,6 +146,7 @@ typedef struct {
     tu_fifo_t _name = TU_FIFO_INIT(_name##_buf, _depth, _type, _overwritable)
 
 bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable);
+bool tu_fifo_set_spsc(tu_fifo_t *f, bool spsc);
 bool tu_fifo_clear(tu_fifo_t *f);
 bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_size, bool overwritable);
 
@@ -0,0 +1,278 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// Throughput benchmark for tu_fifo bulk and single item paths. Every transfer
+// is also checked against the expected stream so the fast paths (index helpers,
+// single byte items) are covered for both power-of-two and non power-of-two depths.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "byte/cycle"
+static inline uint64_t bench_clock(void) { return __rdtsc(); }
+#else
+#define BENCH_UNIT "byte/ns"
+static inline uint64_t bench_clock(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+#endif
+
+#define BENCH_BYTES   (4u * 1024u * 1024u)
+#define MAX_DEPTH     1024
+#define MAX_ITEM      16
+
+static uint8_t ff_buf[MAX_DEPTH * MAX_ITEM];
+static uint8_t src[MAX_DEPTH * MAX_ITEM];
+static uint8_t dst[MAX_DEPTH * MAX_ITEM];
+static tu_fifo_t ff;
+
+void setUp(void)
+{
+  for(size_t i=0; i<sizeof(src); i++) src[i] = (uint8_t) (i*7 + 3);
+  memset(dst, 0, sizeof(dst));
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+// Stream BENCH_BYTES through the fifo in chunks of 'chunk' items. Source data is
+// taken at a rolling offset so every chunk differs and wrap-around is hit at all
+// positions. Returns false on the first mismatch.
+static bool stream_n(uint16_t depth, uint16_t item_size, uint16_t chunk, uint64_t* cycles)
+{
+  if ( !tu_fifo_config(&ff, ff_buf, depth, item_size, false) ) return false;
+
+  uint32_t const chunk_bytes = (uint32_t) chunk * item_size;
+  uint32_t const rounds = BENCH_BYTES / chunk_bytes;
+  uint32_t const span = (uint32_t) (sizeof(src) - chunk_bytes) / item_size;
+  bool ok = true;
+
+  uint32_t offset = 0;
+  uint64_t const start = bench_clock();
+  for(uint32_t r=0; r<rounds; r++)
+  {
+    uint8_t const* p = src + offset * item_size;
+    if ( ++offset == span ) offset = 0;
+
+    if ( tu_fifo_write_n(&ff, p, chunk) != chunk ) { ok = false; break; }
+    if ( tu_fifo_read_n(&ff, dst, chunk) != chunk ) { ok = false; break; }
+    if ( (r & 0x3F) == 0 && memcmp(p, dst, chunk_bytes) ) { ok = false; break; }
+  }
+  *cycles = bench_clock() - start;
+
+  return ok && tu_fifo_empty(&ff);
+}
+
+static bool stream_single(uint16_t depth, uint16_t item_size, uint64_t* cycles)
+{
+  if ( !tu_fifo_config(&ff, ff_buf, depth, item_size, false) ) return false;
+
+  uint32_t const items = BENCH_BYTES / 4 / item_size;
+  uint8_t item[MAX_ITEM];
+  bool ok = true;
+
+  uint8_t const* p = src;
+  uint8_t const* const end = src + depth * item_size;
+  uint64_t const start = bench_clock();
+  for(uint32_t i=0; i<items; i++)
+  {
+    if ( !tu_fifo_write(&ff, p) || !tu_fifo_read(&ff, item) || item[0] != p[0] )
+    {
+      ok = false;
+      break;
+    }
+    p += item_size;
+    if ( p == end ) p = src;
+  }
+  *cycles = bench_clock() - start;
+
+  return ok && tu_fifo_empty(&ff);
+}
+
+static void report(char const* name, uint16_t depth, uint16_t item_size, uint16_t chunk, uint32_t bytes, uint64_t cycles)
+{
+  double const rate = cycles ? (double) bytes / (double) cycles : 0;
+  printf("  %-8s depth %4u item %2u chunk %4u : %7.3f %s\n", name, depth, item_size, chunk, rate, BENCH_UNIT);
+}
+
+//--------------------------------------------------------------------+
+// Tests
+//--------------------------------------------------------------------+
+
+static uint16_t const depths[]     = { 64, 100, 256, 300, 1024 };
+static uint16_t const item_sizes[] = { 1, 2, 4, 12 };
+
+void test_bench_write_read_n(void)
+{
+  for(size_t d=0; d<TU_ARRAY_SIZE(depths); d++)
+  {
+    for(size_t s=0; s<TU_ARRAY_SIZE(item_sizes); s++)
+    {
+      uint16_t const depth = depths[d];
+      uint16_t const item_size = item_sizes[s];
+      uint16_t const chunks[] = { 7, (uint16_t) (depth/2 + 1), depth };
+
+      for(size_t c=0; c<TU_ARRAY_SIZE(chunks); c++)
+      {
+        uint64_t cycles;
+        TEST_ASSERT_TRUE(stream_n(depth, item_size, chunks[c], &cycles));
+
+        uint32_t const chunk_bytes = (uint32_t) chunks[c] * item_size;
+        report("rw_n", depth, item_size, chunks[c], (BENCH_BYTES / chunk_bytes) * chunk_bytes, cycles);
+      }
+    }
+  }
+}
+
+void test_bench_write_read_single(void)
+{
+  for(size_t d=0; d<TU_ARRAY_SIZE(depths); d++)
+  {
+    for(size_t s=0; s<TU_ARRAY_SIZE(item_sizes); s++)
+    {
+      uint16_t const depth = depths[d];
+      uint16_t const item_size = item_sizes[s];
+
+      uint64_t cycles;
+      TEST_ASSERT_TRUE(stream_single(depth, item_size, &cycles));
+
+      report("rw_1", depth, item_size, 1, (BENCH_BYTES / 4 / item_size) * item_size, cycles);
+    }
+  }
+}
+
+// Fill partially, then keep the fifo at a constant level so indices run through
+// the whole [0..2*depth) space, including the 16-bit wrap for depth 0x8000.
+void test_index_space_wrap(void)
+{
+  static uint8_t big_buf[0x8000];
+  uint16_t const depths_wrap[] = { 3, 64, 100, 0x4000, 0x8000 };
+
+  for(size_t d=0; d<TU_ARRAY_SIZE(depths_wrap); d++)
+  {
+    uint16_t const depth = depths_wrap[d];
+    TEST_ASSERT_TRUE(tu_fifo_config(&ff, big_buf, depth, 1, false));
+
+    uint8_t wr = 0, rd = 0;
+    uint16_t const level = (uint16_t) (depth / 2);
+    for(uint16_t i=0; i<level; i++) tu_fifo_write(&ff, &wr), wr++;
+
+    for(uint32_t i=0; i<3u*depth + 17; i++)
+    {
+      uint8_t v;
+      TEST_ASSERT_TRUE(tu_fifo_write(&ff, &wr)); wr++;
+      TEST_ASSERT_TRUE(tu_fifo_read(&ff, &v));
+      TEST_ASSERT_EQUAL(rd, v); rd++;
+      TEST_ASSERT_EQUAL(level, tu_fifo_count(&ff));
+      TEST_ASSERT_EQUAL(depth - level, tu_fifo_remaining(&ff));
+    }
+  }
+}
+
+// Overwritable mode with odd sizes must keep the newest depth items for both
+// masked and unmasked index arithmetic.
+void test_overwritable_non_power_of_two(void)
+{
+  uint16_t const depths_ow[] = { 48, 64 };
+
+  for(size_t d=0; d<TU_ARRAY_SIZE(depths_ow); d++)
+  {
+    uint16_t const depth = depths_ow[d];
+    TEST_ASSERT_TRUE(tu_fifo_config(&ff, ff_buf, depth, 2, true));
+
+    uint32_t written = 0;
+    uint16_t const steps[] = { 5, 31, 17, 3, 29, 11 };
+    for(size_t i=0; i<TU_ARRAY_SIZE(steps); i++)
+    {
+      tu_fifo_write_n(&ff, src + written*2, steps[i]);
+      written += steps[i];
+    }
+
+    TEST_ASSERT_EQUAL(depth, tu_fifo_count(&ff));
+    TEST_ASSERT_EQUAL(depth, tu_fifo_read_n(&ff, dst, depth));
+    TEST_ASSERT_EQUAL_MEMORY(src + (written - depth)*2, dst, depth*2);
+  }
+}
+
+// Word copies from/to a constant address, with the fifo buffer both word aligned
+// and misaligned so both the aligned and the unaligned copy loops are used.
+void test_const_addr_full_words(void)
+{
+#ifndef TUP_MEM_CONST_ADDR
+  TEST_IGNORE_MESSAGE("TUP_MEM_CONST_ADDR not enabled");
+#else
+  static uint32_t ff_buf32[64];
+  uint8_t* const bases[] = { (uint8_t*) ff_buf32, (uint8_t*) ff_buf32 + 1 };
+
+  for(size_t b=0; b<TU_ARRAY_SIZE(bases); b++)
+  {
+    TEST_ASSERT_TRUE(tu_fifo_config(&ff, bases[b], 61, 1, false));
+
+    // 3 bytes first: const copies then start misaligned for base 0 and aligned for base 1
+    tu_fifo_write_n(&ff, src, 3);
+
+    volatile uint32_t reg = 0x44332211;
+    TEST_ASSERT_EQUAL(22, tu_fifo_write_n_const_addr_full_words(&ff, (void const*) &reg, 22));
+
+    uint8_t expect[25];
+    memcpy(expect, src, 3);
+    for(int i=0; i<22; i++) expect[3+i] = (uint8_t) (0x11 + 0x11*(i & 3));
+
+    uint8_t out[25];
+    TEST_ASSERT_EQUAL(3, tu_fifo_read_n(&ff, out, 3));
+
+    uint32_t words[6] = { 0 };
+    for(int i=0; i<5; i++)
+    {
+      volatile uint32_t tx;
+      tu_fifo_read_n_const_addr_full_words(&ff, (void*) &tx, 4);
+      words[i] = tx;
+    }
+    volatile uint32_t tx;
+    tu_fifo_read_n_const_addr_full_words(&ff, (void*) &tx, 2);
+    words[5] = tx;
+
+    memcpy(out+3, words, 22);
+    TEST_ASSERT_EQUAL_MEMORY(expect, out, 25);
+    TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+  }
+#endif
+}
@@ -0,0 +1,260 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// Single producer/single consumer mode: the producer and the consumer run in
+// their own threads (on different cores when the host has more than one) and
+// only synchronize through the fifo indices. The stress tests check that every
+// item arrives exactly once and in order, the benchmark compares lock-free SPSC
+// mode against wrapping each side with a mutex.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+#define STRESS_ITEMS    2000000u
+#define BENCH_BYTES     (16u * 1024u * 1024u)
+#define MAX_DEPTH       1024
+
+static uint32_t ff_buf[MAX_DEPTH];
+static tu_fifo_t ff;
+
+void setUp(void)
+{
+  memset(&ff, 0, sizeof(ff));
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+typedef enum
+{
+  LOCK_NONE,    // lock-free SPSC mode
+  LOCK_SIDE,    // one mutex per side, same as tu_fifo_config_mutex(f, wr, rd)
+  LOCK_SHARED,  // one mutex for both sides
+} lock_mode_t;
+
+typedef struct
+{
+  lock_mode_t mode;
+  uint32_t    total;   // items to transfer
+  uint16_t    chunk;   // max items per call
+  uint32_t    errors;  // consumer side mismatches
+  pthread_mutex_t mutex_wr;
+  pthread_mutex_t mutex_rd;
+} stream_t;
+
+static void stream_lock(stream_t* s, bool wr)
+{
+  if ( s->mode == LOCK_SIDE ) pthread_mutex_lock(wr ? &s->mutex_wr : &s->mutex_rd);
+  if ( s->mode == LOCK_SHARED ) pthread_mutex_lock(&s->mutex_wr);
+}
+
+static void stream_unlock(stream_t* s, bool wr)
+{
+  if ( s->mode == LOCK_SIDE ) pthread_mutex_unlock(wr ? &s->mutex_wr : &s->mutex_rd);
+  if ( s->mode == LOCK_SHARED ) pthread_mutex_unlock(&s->mutex_wr);
+}
+
+// Producer writes an incrementing counter, alternating between write_n() with a
+// varying count and single item write().
+static void* producer(void* arg)
+{
+  stream_t* s = (stream_t*) arg;
+  uint32_t buf[MAX_DEPTH];
+  uint32_t next = 0;
+  uint32_t round = 0;
+
+  while ( next < s->total )
+  {
+    uint16_t n = (uint16_t) (1 + (round++ * 7) % s->chunk);
+    if ( n > s->total - next ) n = (uint16_t) (s->total - next);
+
+    uint16_t written;
+    stream_lock(s, true);
+    if ( n == 1 )
+    {
+      written = tu_fifo_write(&ff, &next) ? 1 : 0;
+    }
+    else
+    {
+      for(uint16_t i=0; i<n; i++) buf[i] = next + i;
+      written = tu_fifo_write_n(&ff, buf, n);
+    }
+    stream_unlock(s, true);
+
+    next += written;
+    if ( written == 0 ) sched_yield();
+  }
+
+  return NULL;
+}
+
+// Consumer checks that items arrive in order, using read_n(), read() and peek()
+static void* consumer(void* arg)
+{
+  stream_t* s = (stream_t*) arg;
+  uint32_t buf[MAX_DEPTH];
+  uint32_t expect = 0;
+  uint32_t round = 0;
+
+  while ( expect < s->total )
+  {
+    uint16_t n = (uint16_t) (1 + (round++ * 5) % s->chunk);
+    uint16_t got;
+
+    stream_lock(s, false);
+    if ( n == 1 )
+    {
+      uint32_t peeked = 0;
+      bool const has_peek = tu_fifo_peek(&ff, &peeked);
+      got = tu_fifo_read(&ff, buf) ? 1 : 0;
+      if ( got && (!has_peek || peeked != buf[0]) ) s->errors++;
+    }
+    else
+    {
+      got = tu_fifo_read_n(&ff, buf, n);
+    }
+    stream_unlock(s, false);
+
+    for(uint16_t i=0; i<got; i++)
+    {
+      if ( buf[i] != expect + i ) s->errors++;
+    }
+    expect += got;
+
+    if ( got == 0 ) sched_yield();
+  }
+
+  return NULL;
+}
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// Run producer and consumer concurrently, returns elapsed seconds
+static double run_stream(stream_t* s)
+{
+  pthread_mutex_init(&s->mutex_wr, NULL);
+  pthread_mutex_init(&s->mutex_rd, NULL);
+  s->errors = 0;
+
+  pthread_t prod, cons;
+  double const start = now_sec();
+  pthread_create(&cons, NULL, consumer, s);
+  pthread_create(&prod, NULL, producer, s);
+  pthread_join(prod, NULL);
+  pthread_join(cons, NULL);
+  double const elapsed = now_sec() - start;
+
+  pthread_mutex_destroy(&s->mutex_wr);
+  pthread_mutex_destroy(&s->mutex_rd);
+
+  return elapsed;
+}
+
+//--------------------------------------------------------------------+
+// Tests
+//--------------------------------------------------------------------+
+
+void test_spsc_mode_rules(void)
+{
+  TEST_ASSERT_TRUE(tu_fifo_config(&ff, ff_buf, 64, 4, true));
+
+  // overwrite moves the read index from the writer side
+  TEST_ASSERT_FALSE(tu_fifo_set_spsc(&ff, true));
+  TEST_ASSERT_TRUE(tu_fifo_set_overwritable(&ff, false));
+  TEST_ASSERT_TRUE(tu_fifo_set_spsc(&ff, true));
+  TEST_ASSERT_FALSE(tu_fifo_set_overwritable(&ff, true));
+
+  // mode survives re-configuration like the mutexes do
+  TEST_ASSERT_TRUE(tu_fifo_config(&ff, ff_buf, 32, 4, false));
+  TEST_ASSERT_TRUE(ff.spsc);
+
+  // but re-configuration can't make it overwritable either, fifo is left untouched
+  TEST_ASSERT_FALSE(tu_fifo_config(&ff, ff_buf, 16, 2, true));
+  TEST_ASSERT_TRUE(ff.spsc);
+  TEST_ASSERT_FALSE(ff.overwritable);
+  TEST_ASSERT_EQUAL(32, ff.depth);
+
+  TEST_ASSERT_TRUE(tu_fifo_set_spsc(&ff, false));
+  TEST_ASSERT_TRUE(tu_fifo_set_overwritable(&ff, true));
+}
+
+void test_spsc_stress(void)
+{
+  // power of two and odd depths, small chunks hit the full/empty edges often
+  uint16_t const depths[] = { 64, 100, 1024 };
+  uint16_t const chunks[] = { 3, 48, 255 };
+
+  for(size_t i=0; i<TU_ARRAY_SIZE(depths); i++)
+  {
+    TEST_ASSERT_TRUE(tu_fifo_config(&ff, ff_buf, depths[i], sizeof(uint32_t), false));
+    TEST_ASSERT_TRUE(tu_fifo_set_spsc(&ff, true));
+
+    stream_t s = { .mode = LOCK_NONE, .total = STRESS_ITEMS, .chunk = chunks[i] };
+    run_stream(&s);
+
+    TEST_ASSERT_EQUAL(0, s.errors);
+    TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+  }
+}
+
+void test_bench_contention(void)
+{
+  char const* names[] = { "spsc", "mutex/side", "mutex/shared" };
+  uint16_t const chunks[] = { 1, 16, 128 };
+
+  for(size_t c=0; c<TU_ARRAY_SIZE(chunks); c++)
+  {
+    for(lock_mode_t mode=LOCK_NONE; mode<=LOCK_SHARED; mode++)
+    {
+      TEST_ASSERT_TRUE(tu_fifo_config(&ff, ff_buf, 256, sizeof(uint32_t), false));
+      TEST_ASSERT_TRUE(tu_fifo_set_spsc(&ff, mode == LOCK_NONE));
+
+      stream_t s = { .mode = mode, .total = BENCH_BYTES / sizeof(uint32_t) / (chunks[c] == 1 ? 8 : 1), .chunk = chunks[c] };
+      double const sec = run_stream(&s);
+      TEST_ASSERT_EQUAL(0, s.errors);
+
+      double const bytes = (double) s.total * sizeof(uint32_t);
+      printf("  %-12s chunk %3u : %8.1f MB/s\n", names[mode], chunks[c], bytes / sec / 1e6);
+    }
+  }
+}
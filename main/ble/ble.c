@@ -1,4 +1,7 @@
 #include "ble.h"
+#include "conn_table.h"
+#include "conn_tuning.h"
+#include "notify.h"
 #include <stdio.h>
 #include <string.h>
 #include "esp_log.h"
@@ -12,17 +15,12 @@
 
 static const char *TAG = "BLE";
 
-#define MAX_CONN 2
-static uint16_t conn_handles[MAX_CONN] = {0};
-
 static ble_rx_callback_t steering_rx_cb = NULL;
 static ble_rx_callback_t pedals_rx_cb   = NULL;
 
 static uint16_t steering_handle;
 static uint16_t pedals_handle;
 
-static bool pedals_notify_enabled[MAX_CONN] = { false };
-
 // UUIDs
 
 // SERVICE
@@ -34,34 +32,66 @@ static const ble_uuid16_t steering_uuid = BLE_UUID16_INIT(0xAB11);
 // PEDALS 16-bit
 static const ble_uuid16_t pedals_uuid = BLE_UUID16_INIT(0xAB12);
 
-// Buffers
-static char steering_buf[50] = {0};
-static char pedals_buf[50]   = {0};
+static ble_rx_stats_t rx_stats = {0};
+
+// Entrega a escrita ao callback sem cópia quando a mbuf é contígua
+static int handle_write(uint16_t conn_handle, struct ble_gatt_access_ctxt *ctxt,
+                        ble_role_t role, ble_rx_callback_t cb)
+{
+    if (ctxt->op != BLE_GATT_ACCESS_OP_WRITE_CHR) return 0;
+
+    ble_conn_t *conn = conn_table_find(conn_handle);
+    if (!conn) return BLE_ATT_ERR_UNLIKELY;
+
+    struct os_mbuf *om = ctxt->om;
+    uint16_t len = OS_MBUF_PKTLEN(om);
+
+    if (len > RX_BUF_LEN) {
+        rx_stats.oversized++;
+        conn->counters.rx_oversized++;
+        ESP_LOGW(TAG, "Escrita de %u bytes excede %d (conn %d)", len, RX_BUF_LEN, conn_handle);
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    // O papel do dispositivo é definido pela característica em que ele escreve
+    if (conn->role == BLE_ROLE_UNKNOWN) {
+        conn->role = role;
+        ESP_LOGI(TAG, "conn %d identificada como %s", conn_handle,
+                 role == BLE_ROLE_WHEEL ? "volante" : "pedais");
+    }
+
+    rx_stats.writes++;
+    conn->counters.rx_writes++;
+    conn->counters.rx_bytes += len;
+    if (!cb) return 0;
+
+    if (SLIST_NEXT(om, om_next) == NULL) {
+        cb((const char *)om->om_data, len);
+    } else {
+        ble_hs_mbuf_to_flat(om, conn->rx_buf, len, NULL);
+        rx_stats.copied++;
+        cb((const char *)conn->rx_buf, len);
+    }
+    return 0;
+}
 
 // Callback escrita STEERING
 static int char_steering_cb(uint16_t conn_handle, uint16_t attr_handle,
                             struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
-    size_t len = OS_MBUF_PKTLEN(ctxt->om);
-    if (len < sizeof(steering_buf)) {
-        ble_hs_mbuf_to_flat(ctxt->om, steering_buf, len, NULL);
-        steering_buf[len] = '\0';
-        if (steering_rx_cb) steering_rx_cb(steering_buf, len);
-    }
-    return 0;
+    return handle_write(conn_handle, ctxt, BLE_ROLE_WHEEL, steering_rx_cb);
 }
 
 // Callback escrita PEDALS
 static int char_pedals_cb(uint16_t conn_handle, uint16_t attr_handle,
                           struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
-    size_t len = OS_MBUF_PKTLEN(ctxt->om);
-    if (len < sizeof(pedals_buf)) {
-        ble_hs_mbuf_to_flat(ctxt->om, pedals_buf, len, NULL);
-        pedals_buf[len] = '\0';
-        if (pedals_rx_cb) pedals_rx_cb(pedals_buf, len);
-    }
-    return 0;
+    return handle_write(conn_handle, ctxt, BLE_ROLE_PEDALS, pedals_rx_cb);
+}
+
+void ble_get_rx_stats(ble_rx_stats_t *out)
+{
+    *out = rx_stats;
 }
 
 // GATT
@@ -89,92 +119,79 @@ static const struct ble_gatt_svc_def gatt_svcs[] = {
 };
 
 // GAP
+static int gap_event_handler(struct ble_gap_event *event, void *arg);
+
+static void start_advertising(void)
+{
+    if (ble_gap_adv_active()) return;
+
+    struct ble_hs_adv_fields fields = {
+        .flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
+        .name = (uint8_t *)"ESP32-S3-NimBLE",
+        .name_len = strlen("ESP32-S3-NimBLE"),
+        .name_is_complete = 1,
+    };
+    ble_gap_adv_set_fields(&fields);
+
+    struct ble_gap_adv_params adv_params = {
+        .conn_mode = BLE_GAP_CONN_MODE_UND,
+        .disc_mode = BLE_GAP_DISC_MODE_GEN,
+    };
+    ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
+                      &adv_params, gap_event_handler, NULL);
+}
+
 static int gap_event_handler(struct ble_gap_event *event, void *arg)
 {
+    conn_tuning_on_event(event);
+
     switch (event->type) {
         case BLE_GAP_EVENT_CONNECT:
             if (event->connect.status == 0) {
                 ESP_LOGI(TAG, "Dispositivo conectado");
 
-                // Armazena handle na primeira posição livre
-                for (int i = 0; i < MAX_CONN; i++) {
-                    if (conn_handles[i] == 0) {
-                        conn_handles[i] = event->connect.conn_handle;
-                        break;
-                    }
+                if (!conn_table_add(event->connect.conn_handle)) {
+                    ESP_LOGW(TAG, "Tabela de conexões cheia, desconectando %d",
+                             event->connect.conn_handle);
+                    ble_gap_terminate(event->connect.conn_handle, BLE_ERR_CONN_LIMIT);
+                    break;
                 }
 
-                        // Verifica se ainda há slots livres e reinicia advertising
-                bool has_free_slot = false;
-                for (int i = 0; i < MAX_CONN; i++) {
-                    if (conn_handles[i] == 0) {
-                        has_free_slot = true;
-                        break;
-                    }
-                }
-                if (has_free_slot) {
-                    struct ble_gap_adv_params adv_params = {
-                        .conn_mode = BLE_GAP_CONN_MODE_UND,
-                        .disc_mode = BLE_GAP_DISC_MODE_GEN,
-                    };
-                    struct ble_hs_adv_fields fields = {
-                        .flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
-                        .name = (uint8_t *)"ESP32-S3-NimBLE",
-                        .name_len = strlen("ESP32-S3-NimBLE"),
-                        .name_is_complete = 1,
-                    };
-                    ble_gap_adv_set_fields(&fields);
-                    ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
-                                    &adv_params, gap_event_handler, NULL);
-                }
+                // Pede intervalo mínimo, DLE e PHY 2M para este link
+                conn_tuning_on_connect(event->connect.conn_handle);
 
+                // Ainda há slots livres: reinicia advertising
+                if (conn_table_count() < MAX_CONN) {
+                    start_advertising();
+                }
+            } else {
+                start_advertising();
             }
             break;
 
         case BLE_GAP_EVENT_DISCONNECT:
             ESP_LOGI(TAG, "Dispositivo desconectado");
-
-            // Limpa handle correspondente
-            for (int i = 0; i < MAX_CONN; i++) {
-                if (conn_handles[i] != event->connect.conn_handle) {
-                    conn_handles[i] = 0;
-                    break;
-                }
-            }
-
-            // Reinicia advertising
-            {
-                struct ble_gap_adv_params adv_params = {
-                    .conn_mode = BLE_GAP_CONN_MODE_UND,
-                    .disc_mode = BLE_GAP_DISC_MODE_GEN,
-                };
-                struct ble_hs_adv_fields fields = {
-                    .flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
-                    .name = (uint8_t *)"ESP32-S3-NimBLE",
-                    .name_len = strlen("ESP32-S3-NimBLE"),
-                    .name_is_complete = 1,
-                };
-                ble_gap_adv_set_fields(&fields);
-                ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
-                                  &adv_params, gap_event_handler, NULL);
-            }
+            conn_table_remove(event->disconnect.conn.conn_handle);
+            start_advertising();
             break;
 
-        case BLE_GAP_EVENT_SUBSCRIBE:
+        case BLE_GAP_EVENT_SUBSCRIBE: {
             ESP_LOGI(TAG, "Cliente %d alterou inscrição: attr=%d, notify=%d",
                     event->subscribe.conn_handle,
                     event->subscribe.attr_handle,
                     event->subscribe.cur_notify);
 
-            for (int i = 0; i < MAX_CONN; i++) {
-                if (conn_handles[i] == event->subscribe.conn_handle) {
-                    pedals_notify_enabled[i] = (event->subscribe.attr_handle == pedals_handle) &&
-                                            event->subscribe.cur_notify;
-                    break;
-                }
+            ble_conn_t *conn = conn_table_find(event->subscribe.conn_handle);
+            if (!conn) break;
+            conn_table_lock();
+            if (event->subscribe.attr_handle == steering_handle) {
+                conn->steering_notify = event->subscribe.cur_notify;
+            } else if (event->subscribe.attr_handle == pedals_handle) {
+                conn->pedals_notify = event->subscribe.cur_notify;
             }
+            conn_table_unlock();
             break;
-
+        }
 
         default:
             break;
@@ -185,20 +202,7 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg)
 // Sync
 static void ble_app_on_sync(void)
 {
-    struct ble_hs_adv_fields fields = {
-        .flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
-        .name = (uint8_t *)"ESP32-S3-NimBLE",
-        .name_len = strlen("ESP32-S3-NimBLE"),
-        .name_is_complete = 1,
-    };
-    ble_gap_adv_set_fields(&fields);
-
-    struct ble_gap_adv_params adv_params = {
-        .conn_mode = BLE_GAP_CONN_MODE_UND,
-        .disc_mode = BLE_GAP_DISC_MODE_GEN,
-    };
-    ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
-                      &adv_params, gap_event_handler, NULL);
+    start_advertising();
 
     ESP_LOGI(TAG, "Advertising iniciado");
 }
@@ -225,6 +229,7 @@ void ble_init(ble_rx_callback_t steering_cb_in, ble_rx_callback_t pedals_cb_in)
     ESP_LOGI(TAG, "Inicializando NimBLE...");
 
     nimble_port_init();
+    notify_init();
     ble_svc_gap_init();
     ble_svc_gatt_init();
     ble_gatts_count_cfg(gatt_svcs);
@@ -239,59 +244,58 @@ void ble_init(ble_rx_callback_t steering_cb_in, ble_rx_callback_t pedals_cb_in)
     ESP_LOGI(TAG, "Handle da característica pedals: %d", pedals_handle);
 }
 
+// Retorno: links que aceitaram a notificação, -2 sem inscritos, -1 nenhum envio aceito
+static int notify_rc(const ble_notify_result_t *r)
+{
+    if (r->subscribed == 0) return -2;
+    return r->sent ? r->sent : -1;
+}
+
 // Envio STEERING
 int ble_send_steering(const char *data, size_t len)
 {
-    struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
-    if (!om) return -1;
-
-    int rc = 0;
-    for (int i = 0; i < MAX_CONN; i++) {
-        if (conn_handles[i]) {
-            rc = ble_gattc_notify_custom(conn_handles[i], steering_handle, om);
-        }
-    }
-    return rc;
+    ble_notify_result_t r;
+    notify_fanout(BLE_CHR_STEERING, steering_handle, data, len, &r);
+    return notify_rc(&r);
 }
 
 // Envio PEDALS
 int ble_send_pedals(const char *data, size_t len)
 {
-    struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
-    if (!om) return -1;
-
-    int rc = 0;
-    for (int i = 0; i < MAX_CONN; i++) {
-        if (conn_handles[i]) {
-            rc = ble_gattc_notify_custom(conn_handles[i], pedals_handle, om);
-        }
-    }
-    return rc;
+    ble_notify_result_t r;
+    notify_fanout(BLE_CHR_PEDALS, pedals_handle, data, len, &r);
+    return notify_rc(&r);
 }
 
 int ble_send_pedal_vibration(uint8_t id, uint8_t value)
 {
     uint8_t payload[2] = { id, value };
-    struct os_mbuf *om = ble_hs_mbuf_from_flat(payload, sizeof(payload));
-    if (!om) return -1;
+    return ble_send_pedal_vibrations(payload, 1);
+}
 
-    int rc = 0;
-    bool sent = false;
+int ble_send_pedal_vibrations(const uint8_t *pairs, size_t count)
+{
+    ble_notify_result_t r;
+    notify_fanout(BLE_CHR_PEDALS, pedals_handle, pairs, count * 2, &r);
 
-    for (int i = 0; i < MAX_CONN; i++) {
-        if (conn_handles[i] && pedals_notify_enabled[i]) {
-            rc = ble_gattc_notify_custom(conn_handles[i], pedals_handle, om);
-            sent = true;
-        }
+    if (r.subscribed == 0) {
+        ESP_LOGD(TAG, "Sem clientes para enviar vibração");
     }
+    return notify_rc(&r);
+}
 
-    if (!sent) {
-        os_mbuf_free_chain(om);  // Libera o buffer se ninguém estiver ouvindo
-        rc = -2;
-        ESP_LOGW(TAG, "Sem clientes para enviar vibração");
+// Chamado pela task dos motores
+uint32_t ble_pedals_conn_interval_us(void)
+{
+    uint32_t itvl = 0;
+    conn_table_lock();
+    for (int i = 0; i < MAX_CONN; i++) {
+        ble_conn_t *conn = conn_table_slot(i);
+        if (conn && conn->pedals_notify && conn->link.itvl_us &&
+            (itvl == 0 || conn->link.itvl_us < itvl)) {
+            itvl = conn->link.itvl_us;
+        }
     }
-
-    return rc;
-
+    conn_table_unlock();
+    return itvl;
 }
-
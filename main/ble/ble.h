@@ -8,11 +8,25 @@
 extern "C" {
 #endif
 
+// Conexões simultâneas: volante + pedais
+#define MAX_CONN 2
+
+// data aponta direto para a mbuf do NimBLE (sem terminador), válido só durante o callback
 typedef void (*ble_rx_callback_t)(const char *data, size_t len);
 
+typedef struct {
+    uint32_t writes;     // Escritas entregues aos callbacks
+    uint32_t copied;     // Escritas fragmentadas que precisaram de cópia
+    uint32_t oversized;  // Escritas rejeitadas por exceder o MTU
+} ble_rx_stats_t;
+
 // Inicializa BLE e registra callbacks para cada característica
 void ble_init(ble_rx_callback_t steering_cb, ble_rx_callback_t pedals_cb);
 
+// Envios via notify vão só para os links inscritos na característica, cada um com
+// a sua mbuf. Retornam o número de links que aceitaram, -2 se ninguém está
+// inscrito ou -1 se nenhum envio foi aceito.
+
 // Envia dados via notify para STEERING
 int ble_send_steering(const char *data, size_t len);
 
@@ -20,6 +34,13 @@ int ble_send_steering(const char *data, size_t len);
 int ble_send_pedals(const char *data, size_t len);
 
 int ble_send_pedal_vibration(uint8_t id, uint8_t value);
+// Vários motores em uma notificação: pares {id, valor} consecutivos
+int ble_send_pedal_vibrations(const uint8_t *pairs, size_t count);
+
+// Menor intervalo de conexão entre os links inscritos na PEDALS (0 se nenhum)
+uint32_t ble_pedals_conn_interval_us(void);
+
+void ble_get_rx_stats(ble_rx_stats_t *out);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,104 @@
+#include "conn_table.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "host/ble_hs.h"
+
+// Índice por hash do handle (endereçamento aberto) apontando para slots estáveis.
+// Tamanho potência de 2 e bem maior que MAX_CONN: sondagem quase sempre de 1 passo.
+#define INDEX_SIZE 8
+#define INDEX_MASK (INDEX_SIZE - 1)
+#define INDEX_FREE 0xFF
+
+_Static_assert(INDEX_SIZE >= 2 * MAX_CONN, "índice da tabela de conexões pequeno demais");
+
+static ble_conn_t conns[MAX_CONN];
+static uint8_t index_slot[INDEX_SIZE] = { [0 ... INDEX_SIZE - 1] = INDEX_FREE };
+static int count = 0;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+void conn_table_lock(void)
+{
+    taskENTER_CRITICAL(&lock);
+}
+
+void conn_table_unlock(void)
+{
+    taskEXIT_CRITICAL(&lock);
+}
+
+static int index_pos(uint16_t conn_handle)
+{
+    int pos = conn_handle & INDEX_MASK;
+    for (int n = 0; n < INDEX_SIZE; n++, pos = (pos + 1) & INDEX_MASK) {
+        uint8_t slot = index_slot[pos];
+        if (slot == INDEX_FREE) return -1;
+        if (conns[slot].conn_handle == conn_handle) return pos;
+    }
+    return -1;
+}
+
+ble_conn_t *conn_table_find(uint16_t conn_handle)
+{
+    int pos = index_pos(conn_handle);
+    return pos < 0 ? NULL : &conns[index_slot[pos]];
+}
+
+ble_conn_t *conn_table_add(uint16_t conn_handle)
+{
+    ble_conn_t *existing = conn_table_find(conn_handle);
+    if (existing) return existing;
+    if (count >= MAX_CONN) return NULL;
+
+    int slot = 0;
+    while (conns[slot].in_use) slot++;
+
+    conn_table_lock();
+    ble_conn_t *c = &conns[slot];
+    memset(c, 0, offsetof(ble_conn_t, rx_buf));
+    c->in_use = true;
+    c->conn_handle = conn_handle;
+
+    int pos = conn_handle & INDEX_MASK;
+    while (index_slot[pos] != INDEX_FREE) pos = (pos + 1) & INDEX_MASK;
+    index_slot[pos] = (uint8_t)slot;
+    count++;
+    conn_table_unlock();
+    return c;
+}
+
+void conn_table_remove(uint16_t conn_handle)
+{
+    int pos = index_pos(conn_handle);
+    if (pos < 0) return;
+
+    conn_table_lock();
+    conns[index_slot[pos]].in_use = false;
+    index_slot[pos] = INDEX_FREE;
+    count--;
+
+    // Remoção com deslocamento para trás: mantém as cadeias de sondagem sem lápides
+    int next = (pos + 1) & INDEX_MASK;
+    while (index_slot[next] != INDEX_FREE) {
+        uint8_t slot = index_slot[next];
+        int home = conns[slot].conn_handle & INDEX_MASK;
+        // Move se a posição livre está entre home e next (circular)
+        if (((next - home) & INDEX_MASK) >= ((next - pos) & INDEX_MASK)) {
+            index_slot[pos] = slot;
+            index_slot[next] = INDEX_FREE;
+            pos = next;
+        }
+        next = (next + 1) & INDEX_MASK;
+    }
+    conn_table_unlock();
+}
+
+ble_conn_t *conn_table_slot(int slot)
+{
+    if (slot < 0 || slot >= MAX_CONN || !conns[slot].in_use) return NULL;
+    return &conns[slot];
+}
+
+int conn_table_count(void)
+{
+    return count;
+}
@@ -0,0 +1,62 @@
+#ifndef CONN_TABLE_H
+#define CONN_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "ble.h"
+#include "conn_tuning.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maior escrita aceita: payload de um ATT Write no MTU preferido
+#define RX_BUF_LEN (CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU - 3)
+
+typedef enum {
+    BLE_ROLE_UNKNOWN = 0,
+    BLE_ROLE_WHEEL,   // Escreve na característica STEERING
+    BLE_ROLE_PEDALS,  // Escreve na característica PEDALS
+} ble_role_t;
+
+typedef struct {
+    uint32_t rx_writes;
+    uint32_t rx_bytes;
+    uint32_t rx_oversized;
+    uint32_t tx_notify_ok;
+    uint32_t tx_notify_fail;
+} ble_conn_counters_t;
+
+// Contexto de uma conexão. O slot é estável enquanto a conexão existir.
+typedef struct {
+    bool in_use;
+    uint16_t conn_handle;
+    uint8_t role;             // ble_role_t
+    bool steering_notify;     // Inscrito na STEERING
+    bool pedals_notify;       // Inscrito na PEDALS
+    ble_link_info_t link;     // Parâmetros negociados (conn_tuning)
+    ble_conn_counters_t counters;
+    uint8_t rx_buf[RX_BUF_LEN]; // Só para escritas fragmentadas em várias mbufs
+} ble_conn_t;
+
+// Só a task do host NimBLE altera a tabela (add/remove) e escreve nos slots,
+// exceto os contadores tx_notify_*, atualizados com o lock por quem notifica.
+// Outras tasks (haptics, TinyUSB) acessam os slots apenas entre
+// conn_table_lock/unlock, copiando o que precisam: fora do lock um slot pode
+// ser liberado e reusado por outra conexão no meio da leitura. O lock é um
+// spinlock (seção crítica): nada de chamadas ao NimBLE ou log dentro dele.
+void conn_table_lock(void);
+void conn_table_unlock(void);
+
+ble_conn_t *conn_table_add(uint16_t conn_handle);  // NULL se cheia
+void conn_table_remove(uint16_t conn_handle);
+ble_conn_t *conn_table_find(uint16_t conn_handle); // O(1)
+ble_conn_t *conn_table_slot(int slot);             // NULL se o slot está livre
+int conn_table_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONN_TABLE_H
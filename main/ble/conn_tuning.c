@@ -0,0 +1,173 @@
+#include "conn_tuning.h"
+#include "conn_table.h"
+#include <string.h>
+#include "esp_log.h"
+#include "host/ble_hs.h"
+
+static const char *TAG = "BLE_CONN";
+
+// Alvo: 7,5 ms (mínimo do BLE) sem slave latency.
+// Se o central recusar, tenta faixas progressivamente mais largas.
+typedef struct {
+    uint16_t itvl_min;  // unidades de 1,25 ms
+    uint16_t itvl_max;
+} itvl_range_t;
+
+static const itvl_range_t itvl_steps[] = {
+    { 6, 6 },    // 7,5 ms
+    { 6, 12 },   // 7,5 - 15 ms
+    { 12, 24 },  // 15 - 30 ms
+};
+#define ITVL_STEPS (sizeof(itvl_steps) / sizeof(itvl_steps[0]))
+
+#define SUPERVISION_TIMEOUT_MS 400
+#define DLE_TX_OCTETS 251
+#define DLE_TX_TIME   2120
+
+static ble_link_info_t *link_find(uint16_t conn_handle)
+{
+    ble_conn_t *c = conn_table_find(conn_handle);
+    return c ? &c->link : NULL;
+}
+
+static int request_params(ble_link_info_t *link)
+{
+    const itvl_range_t *r = &itvl_steps[link->update_attempts < ITVL_STEPS ? link->update_attempts : ITVL_STEPS - 1];
+    struct ble_gap_upd_params params = {
+        .itvl_min = r->itvl_min,
+        .itvl_max = r->itvl_max,
+        .latency = 0,
+        .supervision_timeout = SUPERVISION_TIMEOUT_MS / 10,
+        .min_ce_len = 0,
+        .max_ce_len = 0,
+    };
+    link->update_attempts++;
+
+    int rc = ble_gap_update_params(link->conn_handle, &params);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "conn %d: update_params falhou (%d)", link->conn_handle, rc);
+    }
+    return rc;
+}
+
+// Lê do controlador os parâmetros efetivamente em uso
+static void refresh(ble_link_info_t *link)
+{
+    struct ble_gap_conn_desc desc;
+    bool found = ble_gap_conn_find(link->conn_handle, &desc) == 0;
+    uint8_t tx_phy = link->tx_phy, rx_phy = link->rx_phy;
+    ble_gap_read_le_phy(link->conn_handle, &tx_phy, &rx_phy);
+
+    // O intervalo é lido pela task dos motores
+    conn_table_lock();
+    if (found) {
+        link->itvl_us = desc.conn_itvl * 1250;
+        link->latency = desc.conn_latency;
+        link->timeout_ms = desc.supervision_timeout * 10;
+    }
+    link->tx_phy = tx_phy;
+    link->rx_phy = rx_phy;
+    conn_table_unlock();
+}
+
+static void log_link(const ble_link_info_t *link)
+{
+    ESP_LOGI(TAG, "conn %d: itvl=%lu us lat=%u timeout=%u ms phy=%u/%u mtu=%u dle=%u/%u (pedido %d)",
+             link->conn_handle, (unsigned long)link->itvl_us, link->latency, link->timeout_ms,
+             link->tx_phy, link->rx_phy, link->mtu, link->tx_octets, link->rx_octets,
+             link->dle_requested);
+}
+
+void conn_tuning_on_connect(uint16_t conn_handle)
+{
+    ble_link_info_t *link = link_find(conn_handle);
+    if (!link) return;
+
+    memset(link, 0, sizeof(*link));
+    link->conn_handle = conn_handle;
+    link->mtu = 23;
+    link->tx_octets = 27;
+    link->rx_octets = 27;
+    refresh(link);
+
+    // Cada pedido é independente: se um não for suportado os outros seguem
+    request_params(link);
+    link->dle_requested = ble_gap_set_data_len(conn_handle, DLE_TX_OCTETS, DLE_TX_TIME) == 0;
+    ble_gap_set_prefered_le_phy(conn_handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, 0);
+    ble_gattc_exchange_mtu(conn_handle, NULL, NULL);
+
+    log_link(link);
+}
+
+void conn_tuning_on_event(struct ble_gap_event *event)
+{
+    ble_link_info_t *link;
+
+    switch (event->type) {
+        case BLE_GAP_EVENT_CONN_UPDATE:
+            link = link_find(event->conn_update.conn_handle);
+            if (!link) break;
+            refresh(link);
+            log_link(link);
+
+            // Central recusou ou escolheu acima da faixa pedida: relaxa e tenta de novo
+            if (link->update_attempts < ITVL_STEPS &&
+                (event->conn_update.status != 0 ||
+                 link->itvl_us > itvl_steps[link->update_attempts - 1].itvl_max * 1250 ||
+                 link->latency != 0)) {
+                request_params(link);
+            }
+            break;
+
+        case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+            link = link_find(event->phy_updated.conn_handle);
+            if (!link) break;
+            if (event->phy_updated.status == 0) {
+                link->tx_phy = event->phy_updated.tx_phy;
+                link->rx_phy = event->phy_updated.rx_phy;
+            }
+            log_link(link);
+            break;
+
+#ifdef BLE_GAP_EVENT_DATA_LEN_CHG
+        // Resultado do DLE: o pedido aceito não garante o tamanho, o central decide
+        case BLE_GAP_EVENT_DATA_LEN_CHG:
+            link = link_find(event->data_len_chg.conn_handle);
+            if (!link) break;
+            conn_table_lock();
+            link->tx_octets = event->data_len_chg.max_tx_octets;
+            link->rx_octets = event->data_len_chg.max_rx_octets;
+            conn_table_unlock();
+            log_link(link);
+            break;
+#endif
+
+        case BLE_GAP_EVENT_MTU:
+            link = link_find(event->mtu.conn_handle);
+            if (!link) break;
+            link->mtu = event->mtu.value;
+            log_link(link);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Qualquer task: copia o link com a tabela travada
+bool conn_tuning_get_link(int slot, ble_link_info_t *out)
+{
+    conn_table_lock();
+    ble_conn_t *c = conn_table_slot(slot);
+    if (c) *out = c->link;
+    conn_table_unlock();
+    return c != NULL;
+}
+
+void conn_tuning_log(void)
+{
+    for (int i = 0; i < MAX_CONN; i++) {
+        ble_link_info_t link;
+        if (conn_tuning_get_link(i, &link)) log_link(&link);
+    }
+}
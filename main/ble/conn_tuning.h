@@ -0,0 +1,40 @@
+#ifndef CONN_TUNING_H
+#define CONN_TUNING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ble_gap_event;
+
+// Estado negociado de um link BLE, para diagnóstico
+typedef struct {
+    uint16_t conn_handle;
+    uint32_t itvl_us;        // Intervalo de conexão
+    uint16_t latency;        // Slave latency (eventos)
+    uint16_t timeout_ms;     // Supervision timeout
+    uint8_t tx_phy;          // 1 = 1M, 2 = 2M, 3 = Coded
+    uint8_t rx_phy;
+    uint16_t mtu;
+    bool dle_requested;      // Pedido de Data Length Extension aceito pelo controlador
+    uint16_t tx_octets;      // Payload máximo por pacote negociado (27 sem DLE)
+    uint16_t rx_octets;
+    uint8_t update_attempts; // Pedidos de parâmetros enviados ao central
+} ble_link_info_t;
+
+// Ganchos chamados pelo gap_event_handler (a conexão já deve estar na tabela)
+void conn_tuning_on_connect(uint16_t conn_handle);
+void conn_tuning_on_event(struct ble_gap_event *event);
+
+// Qualquer task. Retorna false se o slot não tem link ativo
+bool conn_tuning_get_link(int slot, ble_link_info_t *out);
+void conn_tuning_log(void); // Todos os links no log (ESP_LOGI)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONN_TUNING_H
@@ -0,0 +1,101 @@
+#include "notify.h"
+#include "conn_table.h"
+#include "esp_log.h"
+#include "host/ble_hs.h"
+#include "os/os_mbuf.h"
+#include "os/os_mempool.h"
+
+static const char *TAG = "BLE_NOTIFY";
+
+// Espaço reservado na frente do payload para os cabeçalhos HCI ACL (4),
+// L2CAP (4) e ATT notify (3), como faz ble_hs_mbuf_att_pkt()
+#define NOTIFY_LEADING_SPACE 12
+#define NOTIFY_MAX_PAYLOAD   RX_BUF_LEN
+
+// Dois envios em voo por link antes de faltar bloco
+#define NOTIFY_POOL_BLOCKS (MAX_CONN * 4)
+#define NOTIFY_BLOCK_SIZE  (sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr) + \
+                            NOTIFY_LEADING_SPACE + NOTIFY_MAX_PAYLOAD)
+
+static os_membuf_t notify_mem[OS_MEMPOOL_SIZE(NOTIFY_POOL_BLOCKS, NOTIFY_BLOCK_SIZE)];
+static struct os_mempool notify_mempool;
+static struct os_mbuf_pool notify_mbuf_pool;
+
+void notify_init(void)
+{
+    int rc = os_mempool_init(&notify_mempool, NOTIFY_POOL_BLOCKS, NOTIFY_BLOCK_SIZE,
+                             notify_mem, "ble_notify");
+    if (rc == 0) {
+        rc = os_mbuf_pool_init(&notify_mbuf_pool, &notify_mempool, NOTIFY_BLOCK_SIZE,
+                               NOTIFY_POOL_BLOCKS);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Falha ao criar pool de notificação (%d)", rc);
+    }
+}
+
+static struct os_mbuf *notify_mbuf(const void *data, uint16_t len)
+{
+    struct os_mbuf *om = os_mbuf_get_pkthdr(&notify_mbuf_pool, 0);
+    if (!om) return NULL;
+
+    om->om_data += NOTIFY_LEADING_SPACE;
+    if (os_mbuf_append(om, data, len) != 0) {
+        os_mbuf_free_chain(om);
+        return NULL;
+    }
+    return om;
+}
+
+static bool subscribed(const ble_conn_t *conn, ble_chr_t chr)
+{
+    return chr == BLE_CHR_STEERING ? conn->steering_notify : conn->pedals_notify;
+}
+
+// Chamado fora da task do host (motores, TinyUSB): os handles inscritos são
+// copiados com a tabela travada e o envio é feito fora do lock. Um handle
+// recém-desconectado só faz o ble_gattc_notify_custom falhar (e liberar a
+// mbuf); os contadores vão para o slot só se ele ainda for da mesma conexão.
+void notify_fanout(ble_chr_t chr, uint16_t attr_handle, const void *data, size_t len,
+                   ble_notify_result_t *res)
+{
+    ble_notify_result_t r = {0};
+    uint16_t handles[MAX_CONN];
+    int n = 0;
+
+    if (len > NOTIFY_MAX_PAYLOAD) len = NOTIFY_MAX_PAYLOAD;
+
+    conn_table_lock();
+    for (int i = 0; i < MAX_CONN; i++) {
+        ble_conn_t *conn = conn_table_slot(i);
+        if (conn && subscribed(conn, chr)) handles[n++] = conn->conn_handle;
+    }
+    conn_table_unlock();
+    r.subscribed = n;
+
+    for (int i = 0; i < n; i++) {
+        bool ok = false;
+        struct os_mbuf *om = notify_mbuf(data, (uint16_t)len);
+        if (!om) {
+            r.no_mem++;
+        } else if (ble_gattc_notify_custom(handles[i], attr_handle, om) == 0) { // Consome om
+            r.sent++;
+            ok = true;
+        } else {
+            r.failed++;
+        }
+
+        conn_table_lock();
+        ble_conn_t *conn = conn_table_find(handles[i]);
+        if (conn) {
+            if (ok) {
+                conn->counters.tx_notify_ok++;
+            } else {
+                conn->counters.tx_notify_fail++;
+            }
+        }
+        conn_table_unlock();
+    }
+
+    if (res) *res = r;
+}
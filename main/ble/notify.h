@@ -0,0 +1,36 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BLE_CHR_STEERING = 0,
+    BLE_CHR_PEDALS,
+} ble_chr_t;
+
+// Resultado de um envio para todos os links inscritos
+typedef struct {
+    uint8_t subscribed;  // Links inscritos na característica
+    uint8_t sent;        // Notificações aceitas pelo NimBLE
+    uint8_t no_mem;      // Pool de notificação sem bloco livre
+    uint8_t failed;      // Recusadas pelo NimBLE (link caiu, fila cheia...)
+} ble_notify_result_t;
+
+// Cria o pool dedicado; chamar antes de iniciar a task do host
+void notify_init(void);
+
+// Envia uma cópia independente do payload para cada link inscrito na característica.
+// Cada chamada a ble_gattc_notify_custom consome a sua própria mbuf.
+void notify_fanout(ble_chr_t chr, uint16_t attr_handle, const void *data, size_t len,
+                   ble_notify_result_t *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NOTIFY_H
@@ -0,0 +1,91 @@
+#ifndef PEDALS_PROTOCOL_H
+#define PEDALS_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Formato legado da característica PEDALS: registros {id, raw_hi, raw_lo}.
+#define PEDALS_RECORD_LEN 3
+#define PEDALS_MAX_RECORDS 84 // Com MTU de 256
+
+// Formato em lote com timestamp (big-endian, como o legado):
+//   [0]    PEDALS_BATCH_MAGIC
+//   [1..4] timestamp base em µs (relógio da unidade de pedais)
+//   [5..]  N amostras {id, offset_hi, offset_lo, raw_hi, raw_lo},
+//          offset em µs relativo ao timestamp base
+// Com MTU de 256 cabem até 49 amostras por escrita/notificação.
+#define PEDALS_BATCH_MAGIC      0xB6
+#define PEDALS_BATCH_HEADER_LEN 5
+#define PEDALS_BATCH_SAMPLE_LEN 5
+#define PEDALS_BATCH_MAX_SAMPLES 49
+
+typedef struct {
+    uint32_t t_us;
+    uint8_t id;
+    uint16_t raw;
+} pedals_sample_t;
+
+static inline bool pedals_is_batch(const uint8_t *data, size_t len)
+{
+    return len >= PEDALS_BATCH_HEADER_LEN && data[0] == PEDALS_BATCH_MAGIC &&
+           (len - PEDALS_BATCH_HEADER_LEN) % PEDALS_BATCH_SAMPLE_LEN == 0;
+}
+
+// Decodifica o lote em out, ordenado por timestamp. Retorna o número de amostras.
+static inline size_t pedals_decode_batch(const uint8_t *data, size_t len,
+                                         pedals_sample_t *out, size_t max)
+{
+    if (!pedals_is_batch(data, len)) return 0;
+
+    uint32_t base = ((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) |
+                    ((uint32_t)data[3] << 8) | data[4];
+    size_t n = (len - PEDALS_BATCH_HEADER_LEN) / PEDALS_BATCH_SAMPLE_LEN;
+    if (n > max) n = max;
+
+    const uint8_t *p = data + PEDALS_BATCH_HEADER_LEN;
+    for (size_t i = 0; i < n; i++, p += PEDALS_BATCH_SAMPLE_LEN) {
+        pedals_sample_t s;
+        s.id = p[0];
+        s.t_us = base + (uint32_t)((p[1] << 8) | p[2]);
+        s.raw = (uint16_t)((p[3] << 8) | p[4]);
+
+        // Inserção: a unidade normalmente já envia em ordem, então é O(n)
+        size_t j = i;
+        while (j > 0 && (int32_t)(out[j - 1].t_us - s.t_us) > 0) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = s;
+    }
+    return n;
+}
+
+// Decodifica registros legados em out, todos com o timestamp de chegada t_us.
+// Pacote com tamanho que não é múltiplo de PEDALS_RECORD_LEN é rejeitado
+// inteiro (retorna 0). IDs não são validados aqui.
+static inline size_t pedals_decode_records(const uint8_t *data, size_t len, uint32_t t_us,
+                                           pedals_sample_t *out, size_t max)
+{
+    if (len % PEDALS_RECORD_LEN != 0) return 0;
+
+    size_t n = len / PEDALS_RECORD_LEN;
+    if (n > max) n = max;
+
+    for (size_t i = 0; i < n; i++, data += PEDALS_RECORD_LEN) {
+        out[i].id = data[0];
+        out[i].t_us = t_us;
+        out[i].raw = (uint16_t)((data[1] << 8) | data[2]);
+    }
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PEDALS_PROTOCOL_H
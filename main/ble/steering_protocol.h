@@ -0,0 +1,106 @@
+#ifndef STEERING_PROTOCOL_H
+#define STEERING_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Formato binário da característica STEERING (little-endian):
+//   [0]    STEERING_BIN_MAGIC
+//   [1..2] máscara de botões pressionados
+//   [3..4] máscara de botões alterados neste pacote
+//   [5]    (opcional) hat: 0-7 = N, NE, L, SE, S, SO, O, NO; 0x0F = centro
+// Qualquer outro primeiro byte cai no formato texto "bXX:V;bYY:V".
+#define STEERING_BIN_MAGIC   0xB5
+#define STEERING_BIN_LEN     5
+#define STEERING_BIN_HAT_LEN 6
+
+typedef struct {
+    uint16_t pressed;
+    uint16_t changed;
+    bool has_hat;
+    uint8_t hat;
+} steering_bin_t;
+
+static inline bool steering_is_binary(const uint8_t *data, size_t len)
+{
+    return len >= STEERING_BIN_LEN && data[0] == STEERING_BIN_MAGIC;
+}
+
+// Tempo constante, sem libc
+static inline bool steering_decode_binary(const uint8_t *data, size_t len, steering_bin_t *out)
+{
+    if (!steering_is_binary(data, len)) return false;
+    out->pressed = (uint16_t)(data[1] | (data[2] << 8));
+    out->changed = (uint16_t)(data[3] | (data[4] << 8));
+    out->has_hat = len >= STEERING_BIN_HAT_LEN;
+    out->hat = out->has_hat ? data[5] : 0x0F;
+    return true;
+}
+
+// Formato texto "bXX:V;bYY:V": V == 1 pressiona, outro valor solta. Tokens
+// malformados são ignorados. Uma passada sobre os bytes, sem cópia, sem libc
+// e sem depender de terminador; retorna false se nenhum token for válido.
+static inline bool steering_decode_text(const uint8_t *data, size_t len, steering_bin_t *out)
+{
+    out->pressed = 0;
+    out->changed = 0;
+    out->has_hat = false;
+    out->hat = 0x0F;
+
+    size_t i = 0;
+    while (i < len) {
+        size_t end = i;
+        while (end < len && data[end] != ';') end++;
+
+        // 'b', 1-2 dígitos, ':', espaços opcionais, sinal opcional, dígitos
+        size_t p = i;
+        int button = -1;
+        if (p < end && data[p] == 'b') {
+            p++;
+            size_t d = p;
+            button = 0;
+            while (p < end && p - d < 2 && data[p] >= '0' && data[p] <= '9') {
+                button = button * 10 + (data[p++] - '0');
+            }
+            if (p == d || p >= end || data[p] != ':' || button > 15) button = -1;
+            p++;
+        }
+
+        if (button >= 0) {
+            while (p < end && data[p] == ' ') p++;
+            bool negative = p < end && data[p] == '-';
+            if (p < end && (data[p] == '-' || data[p] == '+')) p++;
+
+            size_t d = p;
+            uint32_t value = 0;
+            while (p < end && data[p] >= '0' && data[p] <= '9') {
+                if (value < 10) value = value * 10 + (data[p] - '0'); // Satura: só importa == 1
+                p++;
+            }
+
+            if (p > d) {
+                uint16_t bit = (uint16_t)(1u << button);
+                out->changed |= bit;
+                if (value == 1 && !negative) {
+                    out->pressed |= bit;
+                } else {
+                    out->pressed &= (uint16_t)~bit;
+                }
+            }
+        }
+
+        i = end + 1;
+    }
+    return out->changed != 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STEERING_PROTOCOL_H
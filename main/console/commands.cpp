@@ -0,0 +1,328 @@
+#include "commands.h"
+#include "usb/cdc.h"
+#include "pedals/calibration.h"
+#include "pedals/curve.h"
+#include "haptics/haptics.h"
+#include "input/handlers.h"
+#include "input/capture.h"
+#include "telemetry/telemetry.h"
+#include "ble/ble.h"
+#include "ble/conn_tuning.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void console_format_latency(latency_stage_t stage, char *buf, size_t size)
+{
+    latency_summary_t s;
+    latency_get_summary(stage, &s);
+    snprintf(buf, size, "%-8s n=%lu min=%lu avg=%lu p50=%lu p99=%lu max=%lu us",
+             latency_stage_name(stage), (unsigned long)s.count, (unsigned long)s.min_us,
+             (unsigned long)s.avg_us, (unsigned long)s.p50_us, (unsigned long)s.p99_us,
+             (unsigned long)s.max_us);
+}
+
+static const char *const pedal_names[PEDAL_COUNT] = {"acc", "brk", "tht"};
+
+// Nome ("acc", "brk", "tht") ou índice (0..2); avança *arg para depois dele
+static bool parse_pedal(const char **arg, pedal_t *out)
+{
+    const char *s = *arg;
+    while (*s == ' ') s++;
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        size_t n = strlen(pedal_names[i]);
+        if (strncmp(s, pedal_names[i], n) == 0 && (s[n] == ' ' || s[n] == '\0')) {
+            *out = (pedal_t)i;
+            *arg = s + n;
+            return true;
+        }
+    }
+    if (s[0] >= '0' && s[0] < '0' + PEDAL_COUNT && (s[1] == ' ' || s[1] == '\0')) {
+        *out = (pedal_t)(s[0] - '0');
+        *arg = s + 1;
+        return true;
+    }
+    return false;
+}
+
+static void print_calibration(pedal_t pedal)
+{
+    pedal_calibration_t c;
+    calibration_get(pedal, &c);
+    cdc_printf("cal %s min=%u max=%u dz=%u/%u auto=%d\r\n", pedal_names[pedal],
+               c.min, c.max, c.deadzone_low, c.deadzone_high, c.auto_range);
+}
+
+// "cal" lista, "cal <pedal>" mostra, "cal save" grava o auto-range agora e
+// "cal <pedal> <min> <max> [dz_low dz_high [auto]]" aplica e grava
+static void cal_command(const char *arg)
+{
+    while (*arg == ' ') arg++;
+    if (strcmp(arg, "save") == 0) {
+        cdc_send_text(calibration_save() == ESP_OK ? "ok\r\n" : "erro nvs\r\n");
+        return;
+    }
+
+    pedal_t pedal;
+    if (!*arg) {
+        for (int i = 0; i < PEDAL_COUNT; i++) print_calibration((pedal_t)i);
+        return;
+    }
+    if (!parse_pedal(&arg, &pedal)) {
+        cdc_send_text("erro pedal\r\n");
+        return;
+    }
+
+    pedal_calibration_t c;
+    calibration_get(pedal, &c);
+    unsigned v[5] = {c.min, c.max, c.deadzone_low, c.deadzone_high, c.auto_range};
+    int n = sscanf(arg, "%u %u %u %u %u", &v[0], &v[1], &v[2], &v[3], &v[4]);
+    if (n > 0) {
+        if (n < 2 || n == 3 || v[0] > UINT16_MAX || v[1] > UINT16_MAX || v[2] > UINT16_MAX ||
+            v[3] > UINT16_MAX) {
+            cdc_send_text("erro uso: cal <pedal> <min> <max> [dz_low dz_high [auto]]\r\n");
+            return;
+        }
+        c.min = v[0];
+        c.max = v[1];
+        c.deadzone_low = v[2];
+        c.deadzone_high = v[3];
+        c.auto_range = v[4] != 0;
+        esp_err_t err = calibration_set(pedal, &c);
+        if (err == ESP_ERR_INVALID_ARG) {
+            cdc_send_text("erro faixa\r\n");
+            return;
+        }
+        if (err != ESP_OK) cdc_send_text("erro nvs\r\n");
+    }
+    print_calibration(pedal);
+}
+
+static const char *const curve_names[] = {"linear", "gamma", "scurve", "spline"};
+
+static void print_curve(pedal_t pedal)
+{
+    pedal_curve_t c;
+    curve_get(pedal, &c);
+    switch (c.type) {
+        case CURVE_GAMMA:
+            cdc_printf("curve %s gamma %u\r\n", pedal_names[pedal], c.gamma_x100);
+            break;
+        case CURVE_SCURVE:
+            cdc_printf("curve %s scurve %u\r\n", pedal_names[pedal], c.scurve);
+            break;
+        case CURVE_SPLINE:
+            cdc_printf("curve %s spline %u %u %u %u %u\r\n", pedal_names[pedal], c.spline[0],
+                       c.spline[1], c.spline[2], c.spline[3], c.spline[4]);
+            break;
+        default:
+            cdc_printf("curve %s linear\r\n", pedal_names[pedal]);
+            break;
+    }
+}
+
+// "curve" lista, "curve <pedal>" mostra, "curve save" grava e
+// "curve <pedal> linear | gamma <x100> | scurve <0..100> | spline <p0..p4>"
+// aplica e grava (spline em 0..1000, não decrescente)
+static void curve_command(const char *arg)
+{
+    while (*arg == ' ') arg++;
+    if (strcmp(arg, "save") == 0) {
+        cdc_send_text(curve_save() == ESP_OK ? "ok\r\n" : "erro nvs\r\n");
+        return;
+    }
+
+    pedal_t pedal;
+    if (!*arg) {
+        for (int i = 0; i < PEDAL_COUNT; i++) print_curve((pedal_t)i);
+        return;
+    }
+    if (!parse_pedal(&arg, &pedal)) {
+        cdc_send_text("erro pedal\r\n");
+        return;
+    }
+    while (*arg == ' ') arg++;
+    if (!*arg) {
+        print_curve(pedal);
+        return;
+    }
+
+    pedal_curve_t c;
+    curve_get(pedal, &c);
+    int type = -1;
+    for (int i = 0; i < (int)(sizeof(curve_names) / sizeof(curve_names[0])); i++) {
+        size_t n = strlen(curve_names[i]);
+        if (strncmp(arg, curve_names[i], n) == 0 && (arg[n] == ' ' || arg[n] == '\0')) {
+            type = i;
+            arg += n;
+            break;
+        }
+    }
+
+    unsigned v[CURVE_SPLINE_POINTS];
+    int n = sscanf(arg, "%u %u %u %u %u", &v[0], &v[1], &v[2], &v[3], &v[4]);
+    bool ok = true;
+    switch (type) {
+        case CURVE_LINEAR:
+            break;
+        case CURVE_GAMMA:
+            ok = n == 1 && v[0] <= UINT16_MAX;
+            if (ok) c.gamma_x100 = v[0];
+            break;
+        case CURVE_SCURVE:
+            ok = n == 1 && v[0] <= UINT8_MAX;
+            if (ok) c.scurve = v[0];
+            break;
+        case CURVE_SPLINE:
+            ok = n == CURVE_SPLINE_POINTS;
+            for (int i = 0; ok && i < CURVE_SPLINE_POINTS; i++) {
+                ok = v[i] <= UINT16_MAX;
+                c.spline[i] = v[i];
+            }
+            break;
+        default:
+            ok = false;
+            break;
+    }
+    if (!ok) {
+        cdc_send_text("erro uso: curve <pedal> linear | gamma <x100> | scurve <0..100> | spline <p0..p4>\r\n");
+        return;
+    }
+
+    c.type = type;
+    esp_err_t err = curve_set(pedal, &c);
+    if (err == ESP_ERR_INVALID_ARG) {
+        cdc_send_text("erro faixa\r\n");
+        return;
+    }
+    if (err != ESP_OK) cdc_send_text("erro nvs\r\n");
+    print_curve(pedal);
+}
+
+// Comandos de diagnóstico: "lat" imprime os histogramas, "lat reset" zera,
+// "tel <Hz>" liga a telemetria binária, "tel off" desliga, "cdc" e "in" mostram os contadores
+// da serial e dos pacotes BLE.
+// Captura BLE: "cap on", "cap off", "cap dump", "cap load", "cap replay [velocidade]" e "cap".
+// Pedais: "cal ..." (cal_command) e "curve ..." (curve_command).
+// Motores: "hap" mostra os contadores do agendador de vibração.
+// Links BLE: "ble" lista os parâmetros negociados de cada link, "ble log" manda para o log.
+bool console_command(const char *cmd)
+{
+    if (strcmp(cmd, "in") == 0) {
+        input_stats_t st;
+        input_get_stats(&st);
+        cdc_printf("in steering=%lu/%lu invalid, pedals=%lu/%lu invalid, unknown_ids=%lu\r\n",
+                   (unsigned long)st.steering_packets, (unsigned long)st.steering_invalid,
+                   (unsigned long)st.pedal_packets, (unsigned long)st.pedal_invalid,
+                   (unsigned long)st.unknown_ids);
+        return true;
+    }
+
+    if (strncmp(cmd, "cal", 3) == 0 && (cmd[3] == ' ' || cmd[3] == '\0')) {
+        cal_command(cmd + 3);
+        return true;
+    }
+
+    if (strncmp(cmd, "curve", 5) == 0 && (cmd[5] == ' ' || cmd[5] == '\0')) {
+        curve_command(cmd + 5);
+        return true;
+    }
+
+    if (strcmp(cmd, "hap") == 0) {
+        haptics_stats_t st;
+        haptics_get_stats(&st);
+        cdc_printf("hap hid=%lu/%lu invalid requested=%lu coalesced=%lu suppressed=%lu\r\n",
+                   (unsigned long)st.hid_reports, (unsigned long)st.hid_invalid,
+                   (unsigned long)st.requested, (unsigned long)st.coalesced,
+                   (unsigned long)st.suppressed);
+        cdc_printf("hap sent=%lu dropped=%lu retried=%lu\r\n", (unsigned long)st.sent,
+                   (unsigned long)st.dropped, (unsigned long)st.retried);
+        return true;
+    }
+
+    if (strcmp(cmd, "ble") == 0) {
+        int links = 0;
+        for (int i = 0; i < MAX_CONN; i++) {
+            ble_link_info_t l;
+            if (!conn_tuning_get_link(i, &l)) continue;
+            links++;
+            cdc_printf("ble conn=%u itvl=%lu us lat=%u timeout=%u ms phy=%u/%u mtu=%u dle=%u/%u req=%d upd=%u\r\n",
+                       l.conn_handle, (unsigned long)l.itvl_us, l.latency, l.timeout_ms, l.tx_phy,
+                       l.rx_phy, l.mtu, l.tx_octets, l.rx_octets, l.dle_requested, l.update_attempts);
+        }
+        ble_rx_stats_t st;
+        ble_get_rx_stats(&st);
+        cdc_printf("ble links=%d writes=%lu copied=%lu oversized=%lu\r\n", links,
+                   (unsigned long)st.writes, (unsigned long)st.copied, (unsigned long)st.oversized);
+        return true;
+    }
+
+    if (strcmp(cmd, "ble log") == 0) {
+        conn_tuning_log();
+        cdc_send_text("ok\r\n");
+        return true;
+    }
+
+    if (strncmp(cmd, "cap", 3) == 0 && (cmd[3] == ' ' || cmd[3] == '\0')) {
+        const char *arg = cmd + 3;
+        while (*arg == ' ') arg++;
+
+        if (strcmp(arg, "on") == 0) {
+            capture_start();
+        } else if (strcmp(arg, "off") == 0) {
+            capture_stop();
+        } else if (strcmp(arg, "dump") == 0) {
+            capture_dump();
+            return true;
+        } else if (strcmp(arg, "load") == 0) {
+            capture_load_begin();
+            return true;
+        } else if (strncmp(arg, "replay", 6) == 0 && (arg[6] == ' ' || arg[6] == '\0')) {
+            capture_replay(arg[6] ? atoi(arg + 6) : 1);
+            return true;
+        }
+
+        capture_stats_t st;
+        capture_get_stats(&st);
+        cdc_printf("cap %s events=%lu bytes=%lu/%lu overwritten=%lu skipped=%lu\r\n",
+                   st.replaying ? "replaying" : st.capturing ? "on" : "off",
+                   (unsigned long)st.events, (unsigned long)st.bytes, (unsigned long)st.capacity,
+                   (unsigned long)st.overwritten, (unsigned long)st.skipped);
+        return true;
+    }
+
+    if (strcmp(cmd, "cdc") == 0) {
+        cdc_stats_t st;
+        cdc_get_stats(&st);
+        cdc_printf("cdc bytes=%lu writes=%lu flushes=%lu packets=%lu dropped=%lu\r\n",
+                   (unsigned long)st.bytes, (unsigned long)st.writes, (unsigned long)st.flushes,
+                   (unsigned long)st.packets, (unsigned long)st.dropped);
+        return true;
+    }
+
+    if (strncmp(cmd, "tel", 3) == 0 && (cmd[3] == ' ' || cmd[3] == '\0')) {
+        if (strcmp(cmd, "tel off") == 0) {
+            telemetry_stop();
+        } else {
+            int hz = atoi(cmd + 3);
+            telemetry_start(hz > 0 ? hz : TELEMETRY_MAX_RATE_HZ);
+        }
+        return true;
+    }
+
+    if (strncmp(cmd, "lat", 3) != 0 || (cmd[3] != ' ' && cmd[3] != '\0')) return false;
+
+    if (strcmp(cmd, "lat reset") == 0) {
+        latency_reset();
+        cdc_send_text("ok\r\n");
+        return true;
+    }
+
+    char line[96];
+    for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        console_format_latency((latency_stage_t)i, line, sizeof(line));
+        cdc_printf("%s\r\n", line);
+    }
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include "input/latency.h"
+
+// Console de texto da CDC. Só depende das APIs dos módulos (sem FreeRTOS nem
+// TinyUSB diretamente), para poder ser compilado no host e no fuzzer.
+
+// Executa uma linha já terminada em '\0'. Retorna false se não é um comando.
+bool console_command(const char *cmd);
+
+// Uma linha por estágio: "total n=... min=... avg=... p50=... p99=... max=... us"
+void console_format_latency(latency_stage_t stage, char *buf, size_t size);
@@ -0,0 +1,186 @@
+#include "haptics.h"
+#include <atomic>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ble/ble.h"
+}
+
+static const char *TAG = "HAPTICS";
+
+#define HAPTICS_TASK_PRIO  6
+#define HAPTICS_TASK_STACK 3072
+
+// Sem link conhecido, não envia mais rápido que o menor intervalo do BLE
+#define MIN_INTERVAL_US 7500
+// Falta de buffer: espera um intervalo, dobrando a cada falha seguida até isso
+#define MAX_BACKOFF_US 100000
+
+// Slot por motor: bit 8 = pendente, bits 0-7 = valor mais recente
+#define SLOT_PENDING 0x100
+
+static std::atomic<uint16_t> slots[HAPTICS_MOTORS];
+// Contadores lidos por outra task (haptics_get_stats): todos atômicos, relaxed.
+// hid_* só são escritos pelo TinyUSB e sent/dropped/retried/suppressed só pelo
+// agendador; requested/coalesced por qualquer chamador de haptics_set.
+static std::atomic<uint32_t> requested{0};
+static std::atomic<uint32_t> coalesced{0};
+static std::atomic<uint32_t> hid_reports{0};
+static std::atomic<uint32_t> hid_invalid{0};
+static std::atomic<uint32_t> stat_sent{0};
+static std::atomic<uint32_t> stat_dropped{0};
+static std::atomic<uint32_t> stat_retried{0};
+static std::atomic<uint32_t> stat_suppressed{0};
+static TaskHandle_t task = NULL;
+static esp_timer_handle_t pace_timer = NULL; // Acorda a task no próximo envio permitido
+
+// Grava o valor sem acordar o agendador
+static void store(uint8_t motor_id, uint8_t value)
+{
+    requested.fetch_add(1, std::memory_order_relaxed);
+    uint16_t old = slots[motor_id - 1].exchange(SLOT_PENDING | value, std::memory_order_acq_rel);
+    if (old & SLOT_PENDING) {
+        coalesced.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void haptics_set(uint8_t motor_id, uint8_t value)
+{
+    if (motor_id < 1 || motor_id > HAPTICS_MOTORS) return;
+
+    store(motor_id, value);
+    if (task) xTaskNotifyGive(task);
+}
+
+// Contexto da task do TinyUSB: só grava os slots, o envio BLE fica com o agendador
+void haptics_on_hid_output(const uint8_t *report, uint16_t len)
+{
+    if (len != HAPTICS_MOTORS) {
+        hid_invalid.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Todos os motores antes de acordar a task: um report, uma notificação
+    hid_reports.fetch_add(1, std::memory_order_relaxed);
+    for (int m = 0; m < HAPTICS_MOTORS; m++) {
+        uint8_t value = report[m] > 100 ? 100 : report[m];
+        store(m + 1, value);
+    }
+    if (task) xTaskNotifyGive(task);
+}
+
+static void pace_timer_cb(void *)
+{
+    xTaskNotifyGive(task);
+}
+
+// Acorda a task daqui a wait_us. Sem timer, cai para ticks arredondados para
+// cima (nunca 0: com 100 Hz, 7,5 ms viraria espera nenhuma)
+static void wait_until(int64_t wait_us)
+{
+    if (pace_timer) {
+        esp_timer_stop(pace_timer); // Um notify durante a espera só reagenda
+        esp_timer_start_once(pace_timer, wait_us);
+        return;
+    }
+    TickType_t ticks = (TickType_t)((wait_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+    vTaskDelay(ticks);
+    xTaskNotifyGive(task);
+}
+
+static void haptics_task(void *)
+{
+    uint8_t last_sent[HAPTICS_MOTORS];
+    bool has_sent[HAPTICS_MOTORS] = {};
+    int64_t next_send_us = 0; // Próximo envio permitido (ritmo do link ou back-off)
+    uint32_t backoff_us = 0;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Respeita o ritmo do link: uma notificação por evento de conexão. Os
+        // valores que chegam durante a espera são juntados no mesmo envio.
+        int64_t now = esp_timer_get_time();
+        if (now < next_send_us) {
+            wait_until(next_send_us - now);
+            continue;
+        }
+
+        // Junta todos os motores alterados em uma única notificação
+        uint8_t pairs[HAPTICS_MOTORS * 2];
+        size_t count = 0;
+        for (int m = 0; m < HAPTICS_MOTORS; m++) {
+            uint16_t slot = slots[m].exchange(0, std::memory_order_acq_rel);
+            if (!(slot & SLOT_PENDING)) continue;
+
+            uint8_t value = slot & 0xFF;
+            if (has_sent[m] && last_sent[m] == value) {
+                stat_suppressed.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            pairs[count * 2] = m + 1;
+            pairs[count * 2 + 1] = value;
+            count++;
+        }
+        if (count == 0) continue;
+
+        uint32_t interval = ble_pedals_conn_interval_us();
+        if (interval < MIN_INTERVAL_US) interval = MIN_INTERVAL_US;
+
+        int rc = ble_send_pedal_vibrations(pairs, count);
+        now = esp_timer_get_time();
+        next_send_us = now + interval;
+
+        if (rc > 0) {
+            stat_sent.fetch_add(1, std::memory_order_relaxed);
+            backoff_us = 0;
+            for (size_t i = 0; i < count; i++) {
+                last_sent[pairs[i * 2] - 1] = pairs[i * 2 + 1];
+                has_sent[pairs[i * 2] - 1] = true;
+            }
+        } else if (rc == -2) {
+            stat_dropped.fetch_add(count, std::memory_order_relaxed);
+            backoff_us = 0;
+        } else {
+            // Sem buffer: devolve ao slot, a menos que já exista valor mais novo,
+            // e tenta de novo depois do back-off em vez de girar na prioridade 6
+            for (size_t i = 0; i < count; i++) {
+                uint16_t expected = 0;
+                slots[pairs[i * 2] - 1].compare_exchange_strong(expected, SLOT_PENDING | pairs[i * 2 + 1]);
+            }
+            stat_retried.fetch_add(count, std::memory_order_relaxed);
+            backoff_us = backoff_us ? backoff_us * 2 : interval;
+            if (backoff_us > MAX_BACKOFF_US) backoff_us = MAX_BACKOFF_US;
+            next_send_us = now + backoff_us;
+            wait_until(backoff_us);
+        }
+    }
+}
+
+void haptics_init()
+{
+    esp_timer_create_args_t args = {};
+    args.callback = pace_timer_cb;
+    args.name = "haptics_pace";
+    if (esp_timer_create(&args, &pace_timer) != ESP_OK) {
+        pace_timer = NULL;
+    }
+
+    if (xTaskCreate(haptics_task, "Haptics", HAPTICS_TASK_STACK, NULL, HAPTICS_TASK_PRIO, &task) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar task de haptics");
+    }
+}
+
+void haptics_get_stats(haptics_stats_t *out)
+{
+    out->hid_reports = hid_reports.load(std::memory_order_relaxed);
+    out->hid_invalid = hid_invalid.load(std::memory_order_relaxed);
+    out->requested = requested.load(std::memory_order_relaxed);
+    out->coalesced = coalesced.load(std::memory_order_relaxed);
+    out->suppressed = stat_suppressed.load(std::memory_order_relaxed);
+    out->sent = stat_sent.load(std::memory_order_relaxed);
+    out->dropped = stat_dropped.load(std::memory_order_relaxed);
+    out->retried = stat_retried.load(std::memory_order_relaxed);
+}
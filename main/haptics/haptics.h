@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+// Motores de vibração da unidade de pedais (IDs do protocolo BLE 0x01..0x03)
+#define HAPTICS_MOTORS 3
+
+typedef struct {
+    uint32_t hid_reports; // Output reports recebidos do host
+    uint32_t hid_invalid; // Output reports descartados (tamanho errado)
+    uint32_t requested;  // Chamadas a haptics_set
+    uint32_t coalesced;  // Valores substituídos antes de serem enviados
+    uint32_t suppressed; // Valores iguais ao último enviado, não reenviados
+    uint32_t sent;       // Notificações enviadas (cada uma com 1 a 3 motores)
+    uint32_t dropped;    // Descartados sem link inscrito
+    uint32_t retried;    // Reenfileirados por falta de buffer
+} haptics_stats_t;
+
+// Cria a task do agendador
+void haptics_init();
+
+// Define a intensidade de um motor (id 1..3, valor 0..100). Não bloqueia e pode
+// ser chamada de qualquer task: só o valor mais recente de cada motor é enviado,
+// no máximo uma notificação por evento de conexão.
+void haptics_set(uint8_t motor_id, uint8_t value);
+
+// Output report HID: HAPTICS_MOTORS bytes, intensidade 0..100 de cada motor
+void haptics_on_hid_output(const uint8_t *report, uint16_t len);
+
+// Qualquer task (ex.: comando "hap" da CDC)
+void haptics_get_stats(haptics_stats_t *out);
@@ -0,0 +1,415 @@
+#include "capture.h"
+#include <atomic>
+#include <cstring>
+#include "usb/cdc.h"
+#include "usb/gamepad.h"
+#include "pedals/filter.h"
+#include "telemetry/cobs.h"
+#include "latency.h"
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "class/cdc/cdc_device.h"
+#include "sdkconfig.h"
+}
+
+static const char *TAG = "CAPTURE";
+
+#ifdef CONFIG_POLILANTE_CAPTURE_SIZE
+#define CAPTURE_SIZE CONFIG_POLILANTE_CAPTURE_SIZE
+#else
+#define CAPTURE_SIZE 16384
+#endif
+
+#define CAPTURE_TASK_PRIO  3
+#define CAPTURE_TASK_STACK 3072
+
+// Upload parado por mais que isso (ferramenta do host morreu no meio):
+// a CDC volta ao modo texto no próximo pacote recebido
+#define LOAD_TIMEOUT_US 2000000
+
+// Evento guardado no ring: [len u16][fonte u8][t_us u32][payload]
+#define STORED_HDR 7
+#define PAYLOAD_MAX 256
+
+// Quadros da CDC: EVENT é o maior
+#define EVENT_HDR 6
+#define STATE_LEN (5 + 2 + 1 + 2 * GAMEPAD_AXIS_COUNT)
+#define FRAME_MAX COBS_MAX_LEN(EVENT_HDR + PAYLOAD_MAX)
+
+typedef enum {
+    MODE_IDLE = 0,
+    MODE_CAPTURING,
+    MODE_REPLAYING,
+} capture_mode_t;
+
+// Ring com sobrescrita dos mais antigos; índices crescem livremente.
+// Protegido por lock: o pipeline só tenta pegar sem esperar.
+static uint8_t ring[CAPTURE_SIZE];
+static uint32_t head = 0;
+static uint32_t tail = 0;
+static uint32_t events = 0;
+static uint32_t overwritten = 0;
+static SemaphoreHandle_t lock = NULL;
+
+static std::atomic<uint8_t> mode{MODE_IDLE};
+static std::atomic<uint32_t> skipped{0};
+static TaskHandle_t worker = NULL;  // Dump ou replay em andamento
+static bool loading = false;        // Contexto do TinyUSB apenas
+static uint32_t replay_index = 0;   // Task do pipeline apenas
+
+static void ring_write(uint32_t pos, const void *src, uint32_t n)
+{
+    uint32_t off = pos % CAPTURE_SIZE;
+    uint32_t first = n < CAPTURE_SIZE - off ? n : CAPTURE_SIZE - off;
+    memcpy(&ring[off], src, first);
+    memcpy(ring, (const uint8_t *)src + first, n - first);
+}
+
+static void ring_read(uint32_t pos, void *dst, uint32_t n)
+{
+    uint32_t off = pos % CAPTURE_SIZE;
+    uint32_t first = n < CAPTURE_SIZE - off ? n : CAPTURE_SIZE - off;
+    memcpy(dst, &ring[off], first);
+    memcpy((uint8_t *)dst + first, ring, n - first);
+}
+
+static uint16_t stored_len(uint32_t pos)
+{
+    uint8_t b[2];
+    ring_read(pos, b, 2);
+    return b[0] | (b[1] << 8);
+}
+
+static inline void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Com o lock
+static void append(uint8_t source, const uint8_t *data, size_t len, uint32_t t_us)
+{
+    uint32_t need = STORED_HDR + len;
+    if (len > PAYLOAD_MAX) return;
+
+    while (CAPTURE_SIZE - (head - tail) < need) {
+        tail += STORED_HDR + stored_len(tail);
+        events--;
+        overwritten++;
+    }
+
+    uint8_t hdr[STORED_HDR];
+    hdr[0] = len & 0xFF;
+    hdr[1] = len >> 8;
+    hdr[2] = source;
+    put32(&hdr[3], t_us);
+    ring_write(head, hdr, STORED_HDR);
+    ring_write(head + STORED_HDR, data, len);
+    head += need;
+    events++;
+}
+
+static void clear()
+{
+    head = tail = 0;
+    events = 0;
+    overwritten = 0;
+}
+
+// Quadros de dump/replay: espera espaço no FIFO, sem cortar quadros
+static bool send_frame(const uint8_t *raw, size_t len, bool wait)
+{
+    uint8_t frame[FRAME_MAX];
+    size_t n = cobs_encode(raw, len, frame);
+
+    while (tud_cdc_write_available() < n) {
+        if (!wait || !tud_cdc_connected()) return false;
+        vTaskDelay(1);
+    }
+    return cdc_write(frame, n) == n;
+}
+
+static void send_marker(uint8_t type)
+{
+    send_frame(&type, 1, true);
+}
+
+static void dump_task(void *)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    uint8_t begin[6] = {CAPTURE_FRAME_BEGIN, CAPTURE_VERSION};
+    put32(&begin[2], events);
+    bool ok = send_frame(begin, sizeof(begin), true);
+
+    uint8_t raw[EVENT_HDR + PAYLOAD_MAX];
+    for (uint32_t pos = tail; ok && pos != head;) {
+        uint8_t hdr[STORED_HDR];
+        ring_read(pos, hdr, STORED_HDR);
+        uint16_t len = hdr[0] | (hdr[1] << 8);
+
+        raw[0] = CAPTURE_FRAME_EVENT;
+        memcpy(&raw[1], &hdr[2], 5); // Fonte + timestamp
+        ring_read(pos + STORED_HDR, &raw[EVENT_HDR], len);
+        ok = send_frame(raw, EVENT_HDR + len, true);
+
+        pos += STORED_HDR + len;
+    }
+
+    if (ok) send_marker(CAPTURE_FRAME_END);
+    xSemaphoreGive(lock);
+
+    ESP_LOGI(TAG, "Dump %s", ok ? "concluído" : "interrompido");
+    worker = NULL;
+    vTaskDelete(NULL);
+}
+
+static void replay_task(void *arg)
+{
+    uint32_t speed = (uint32_t)(uintptr_t)arg;
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    uint32_t n = events;
+    if (n == 0) {
+        mode.store(MODE_IDLE, std::memory_order_release);
+        send_marker(CAPTURE_FRAME_END);
+    }
+
+    // O pipeline usa os timestamps originais, então a saída não depende do
+    // ritmo do replay; a espera só reproduz a cadência (resolução de 1 tick)
+    int64_t start_us = esp_timer_get_time();
+    uint32_t t0 = 0;
+    uint32_t pos = tail;
+    uint8_t payload[PAYLOAD_MAX];
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t hdr[STORED_HDR];
+        ring_read(pos, hdr, STORED_HDR);
+        uint16_t len = hdr[0] | (hdr[1] << 8);
+        uint32_t t_us = get32(&hdr[3]);
+        ring_read(pos + STORED_HDR, payload, len);
+        pos += STORED_HDR + len;
+
+        if (i == 0) t0 = t_us;
+        if (speed) {
+            int64_t due = start_us + (int64_t)(t_us - t0) / speed;
+            int64_t wait = due - esp_timer_get_time();
+            if (wait >= portTICK_PERIOD_MS * 1000) vTaskDelay(pdMS_TO_TICKS(wait / 1000));
+        }
+
+        // Cada evento gera um quadro STATE: não adianta correr mais que a CDC
+        while (tud_cdc_connected() && tud_cdc_write_available() < 2 * COBS_MAX_LEN(STATE_LEN)) {
+            vTaskDelay(1);
+        }
+
+        uint8_t flags = (i == 0 ? PIPELINE_FLAG_REPLAY_FIRST : 0) |
+                        (i == n - 1 ? PIPELINE_FLAG_REPLAY_LAST : 0);
+        while (!pipeline_push_replay((pipeline_source_t)hdr[2], payload, len, t_us, flags)) {
+            vTaskDelay(1);
+        }
+    }
+
+    xSemaphoreGive(lock);
+    worker = NULL;
+    vTaskDelete(NULL);
+}
+
+void capture_init()
+{
+    lock = xSemaphoreCreateMutex();
+    if (!lock) ESP_LOGE(TAG, "Falha ao criar lock da captura");
+}
+
+void capture_start()
+{
+    if (!lock || mode.load() == MODE_REPLAYING) return;
+    if (xSemaphoreTake(lock, pdMS_TO_TICKS(10)) != pdTRUE) return;
+    clear();
+    mode.store(MODE_CAPTURING, std::memory_order_release);
+    xSemaphoreGive(lock);
+}
+
+void capture_stop()
+{
+    uint8_t expected = MODE_CAPTURING;
+    mode.compare_exchange_strong(expected, (uint8_t)MODE_IDLE);
+}
+
+void capture_dump()
+{
+    if (!lock || worker) return;
+    if (xTaskCreate(dump_task, "Capture_Dump", CAPTURE_TASK_STACK, NULL, CAPTURE_TASK_PRIO, &worker) != pdPASS) {
+        worker = NULL;
+    }
+}
+
+void capture_replay(uint32_t speed)
+{
+    if (!lock || worker || loading) return;
+    mode.store(MODE_REPLAYING, std::memory_order_release);
+    if (xTaskCreate(replay_task, "Capture_Replay", CAPTURE_TASK_STACK, (void *)(uintptr_t)speed,
+                    CAPTURE_TASK_PRIO, &worker) != pdPASS) {
+        worker = NULL;
+        mode.store(MODE_IDLE, std::memory_order_release);
+    }
+}
+
+// Upload interrompido: o ring fica vazio em vez de com uma captura parcial
+static void load_abort(const char *reason)
+{
+    loading = false;
+    if (xSemaphoreTake(lock, pdMS_TO_TICKS(10)) == pdTRUE) {
+        clear();
+        xSemaphoreGive(lock);
+    }
+    ESP_LOGW(TAG, "Upload abortado: %s", reason);
+    cdc_printf("erro %s\r\n", reason);
+}
+
+static void load_timeout()
+{
+    load_abort("timeout");
+}
+
+void capture_load_begin()
+{
+    if (!lock || worker || mode.load() == MODE_REPLAYING) return;
+    capture_stop();
+    loading = true;
+    cdc_set_rx_delimiter(0x00, LOAD_TIMEOUT_US, load_timeout);
+}
+
+bool capture_loading()
+{
+    return loading;
+}
+
+void capture_load_frame(const uint8_t *frame, size_t len)
+{
+    uint8_t raw[EVENT_HDR + PAYLOAD_MAX];
+    int n = cobs_decode(frame, len, raw, sizeof(raw));
+    if (n < 0) {
+        // Não é COBS (ex.: texto digitado depois de um upload interrompido)
+        cdc_set_rx_delimiter('\n');
+        load_abort("quadro");
+        return;
+    }
+    if (n == 0) {
+        skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    switch (raw[0]) {
+        case CAPTURE_FRAME_BEGIN:
+        case CAPTURE_FRAME_EVENT:
+            if (xSemaphoreTake(lock, pdMS_TO_TICKS(10)) != pdTRUE) {
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (raw[0] == CAPTURE_FRAME_BEGIN) {
+                clear();
+            } else if (n >= EVENT_HDR && raw[1] <= PIPELINE_SRC_PEDALS) {
+                append(raw[1], &raw[EVENT_HDR], n - EVENT_HDR, get32(&raw[2]));
+            }
+            xSemaphoreGive(lock);
+            break;
+        case CAPTURE_FRAME_END:
+            loading = false;
+            cdc_set_rx_delimiter('\n');
+            cdc_printf("ok %lu\r\n", (unsigned long)events);
+            break;
+        default:
+            skipped.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+}
+
+// Leitura informativa, sem o lock
+void capture_get_stats(capture_stats_t *out)
+{
+    uint8_t m = mode.load(std::memory_order_acquire);
+    out->events = events;
+    out->bytes = head - tail;
+    out->capacity = CAPTURE_SIZE;
+    out->overwritten = overwritten;
+    out->skipped = skipped.load(std::memory_order_relaxed);
+    out->capturing = m == MODE_CAPTURING;
+    out->replaying = m == MODE_REPLAYING;
+}
+
+// Estado inicial conhecido para o replay ser determinístico
+static void reset_pipeline_state()
+{
+    for (int p = 0; p < PEDAL_COUNT; p++) {
+        filter_config_t cfg;
+        filter_get((pedal_t)p, &cfg);
+        filter_set((pedal_t)p, &cfg);
+    }
+
+    gamepad_begin_update();
+    gamepad_set_buttons(0, 0xFFFF);
+    gamepad_set_hat(GAMEPAD_HAT_CENTERED);
+    for (int a = 0; a < GAMEPAD_AXIS_COUNT; a++) gamepad_set_axis16((gamepad_axis_t)a, 0);
+    gamepad_end_update();
+
+    replay_index = 0;
+}
+
+bool capture_before_event(pipeline_source_t source, const uint8_t *data, size_t len,
+                          int64_t t_us, uint8_t flags)
+{
+    if (flags & PIPELINE_FLAG_REPLAY) {
+        if (flags & PIPELINE_FLAG_REPLAY_FIRST) reset_pipeline_state();
+        return true;
+    }
+
+    uint8_t m = mode.load(std::memory_order_acquire);
+    if (m == MODE_REPLAYING) return false;
+
+    if (m == MODE_CAPTURING) {
+        if (xSemaphoreTake(lock, 0) == pdTRUE) {
+            append(source, data, len, (uint32_t)t_us);
+            xSemaphoreGive(lock);
+        } else {
+            skipped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+void capture_after_replay(uint8_t flags)
+{
+    uint16_t buttons;
+    int16_t axes[GAMEPAD_AXIS_COUNT];
+    uint8_t hat;
+    gamepad_read_state(&buttons, axes, &hat);
+
+    uint8_t raw[STATE_LEN];
+    raw[0] = CAPTURE_FRAME_STATE;
+    put32(&raw[1], replay_index++);
+    raw[5] = buttons & 0xFF;
+    raw[6] = buttons >> 8;
+    raw[7] = hat;
+    for (int a = 0; a < GAMEPAD_AXIS_COUNT; a++) {
+        raw[8 + 2 * a] = (uint16_t)axes[a] & 0xFF;
+        raw[9 + 2 * a] = (uint16_t)axes[a] >> 8;
+    }
+    send_frame(raw, sizeof(raw), false);
+
+    if (flags & PIPELINE_FLAG_REPLAY_LAST) {
+        send_marker(CAPTURE_FRAME_END);
+        latency_reset(); // Timestamps originais distorcem os histogramas
+        mode.store(MODE_IDLE, std::memory_order_release);
+        ESP_LOGI(TAG, "Replay concluído: %lu eventos", (unsigned long)replay_index);
+    }
+}
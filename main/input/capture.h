@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "pipeline.h"
+
+// Captura das escritas GATT para reproduzir bugs de campo: cada evento do
+// pipeline (característica, timestamp, payload) vai para um ring em RAM que
+// sobrescreve os mais antigos. A captura pode ser baixada pela CDC, carregada
+// de volta (outro hub, outro firmware) e reproduzida pelo mesmo pipeline.
+//
+// Fluxo binário na CDC, quadros COBS (telemetry/cobs.h), little-endian:
+//   CAPTURE_FRAME_BEGIN  [tipo][versão][n° de eventos u32]
+//   CAPTURE_FRAME_EVENT  [tipo][fonte][t_us u32][payload]
+//   CAPTURE_FRAME_END    [tipo]
+//   CAPTURE_FRAME_STATE  [tipo][índice u32][botões u16][hat][eixos 7 x i16]
+// BEGIN/EVENT/END formam o dump e o upload; STATE é emitido depois de cada
+// evento reproduzido, com o estado do gamepad resultante, e o replay termina
+// com END. O decodificador do lado do host é tools/ble_capture.py.
+#define CAPTURE_FRAME_EVENT 0x10
+#define CAPTURE_FRAME_BEGIN 0x11
+#define CAPTURE_FRAME_END   0x12
+#define CAPTURE_FRAME_STATE 0x13
+#define CAPTURE_VERSION 1
+
+typedef struct {
+    uint32_t events;      // Eventos guardados no ring agora
+    uint32_t bytes;       // Bytes ocupados
+    uint32_t capacity;    // Tamanho do ring
+    uint32_t overwritten; // Eventos antigos sobrescritos
+    uint32_t skipped;     // Eventos não capturados (dump/upload em andamento)
+    bool capturing;
+    bool replaying;
+} capture_stats_t;
+
+void capture_init();
+
+// Comandos (contexto do TinyUSB)
+void capture_start();      // Limpa o ring e começa a capturar
+void capture_stop();
+void capture_dump();       // Envia o ring pela CDC em uma task própria
+void capture_load_begin(); // Próximos quadros COBS da CDC formam uma captura
+bool capture_loading();
+void capture_load_frame(const uint8_t *frame, size_t len);
+void capture_replay(uint32_t speed); // 1 = tempo original, N = N vezes mais rápido, 0 = sem espera
+void capture_get_stats(capture_stats_t *out);
+
+// Ganchos do pipeline (task do pipeline). before retorna false para não
+// processar o evento: entrada ao vivo é descartada durante o replay.
+bool capture_before_event(pipeline_source_t source, const uint8_t *data, size_t len,
+                          int64_t t_us, uint8_t flags);
+void capture_after_replay(uint8_t flags);
@@ -0,0 +1,91 @@
+#include "handlers.h"
+#include "usb/gamepad.h"
+#include "pedals/calibration.h"
+#include "pedals/filter.h"
+#include "telemetry/telemetry.h"
+#include "esp_log.h"
+extern "C" {
+#include "ble/steering_protocol.h"
+#include "ble/pedals_protocol.h"
+}
+
+// Sem dependência de FreeRTOS, TinyUSB ou NimBLE: o tempo vem do chamador
+// e a saída é o estado do gamepad
+
+static const char *TAG = "INPUT";
+
+static input_stats_t stats = {};
+
+void input_steering(const uint8_t *data, size_t len, int64_t t_us) {
+    stats.steering_packets++;
+
+    // Formato binário: máscaras aplicadas direto; texto "bXX:V;..." decodificado
+    // para as mesmas máscaras, sem cópia nem libc
+    steering_bin_t bin;
+    if (!steering_decode_binary(data, len, &bin) && !steering_decode_text(data, len, &bin)) {
+        stats.steering_invalid++;
+        ESP_LOGD(TAG, "STEERING inválido: %.*s", (int)len, (const char *)data);
+        return;
+    }
+
+    gamepad_begin_update_at(t_us);
+    gamepad_set_buttons(bin.pressed, bin.changed);
+    if (bin.has_hat) gamepad_set_hat(bin.hat);
+    gamepad_end_update();
+}
+
+// Eixo do gamepad de cada pedal (ID do protocolo - 1)
+static const gamepad_axis_t pedal_axis[PEDAL_COUNT] = {
+    GAMEPAD_AXIS_X,  // ACC
+    GAMEPAD_AXIS_Y,  // BRK
+    GAMEPAD_AXIS_Z,  // THT
+};
+
+// Filtro -> calibração/curva -> gamepad. Amostra que não passa no gate não gera report.
+static void pedal_sample(pedal_t pedal, uint16_t raw, uint32_t t_us) {
+    telemetry_note_pedal(pedal, raw);
+
+    uint16_t filtered;
+    if (filter_apply(pedal, raw, t_us, &filtered)) {
+        gamepad_set_axis16(pedal_axis[pedal], calibration_apply(pedal, filtered));
+    }
+}
+
+// Amostras em ordem pelo filtro; o gamepad publica um único snapshot por
+// pacote, com os três eixos consistentes
+static void pedal_samples(const pedals_sample_t *samples, size_t n, int64_t t_us) {
+    gamepad_begin_update_at(t_us);
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i].id >= 0x01 && samples[i].id <= PEDAL_COUNT) {
+            pedal_sample((pedal_t)(samples[i].id - 1), samples[i].raw, samples[i].t_us);
+        } else {
+            stats.unknown_ids++;
+        }
+    }
+    gamepad_end_update();
+}
+
+// Entrada vinda de fora do hub: nada de log por registro, só contadores
+void input_pedals(const uint8_t *data, size_t len, int64_t t_us) {
+    stats.pedal_packets++;
+
+    pedals_sample_t samples[PEDALS_MAX_RECORDS];
+    size_t n;
+    if (pedals_is_batch(data, len)) {
+        n = pedals_decode_batch(data, len, samples, PEDALS_BATCH_MAX_SAMPLES);
+    } else {
+        // Pacote sem timestamp: usa o instante de chegada no host BLE
+        n = pedals_decode_records(data, len, (uint32_t)t_us, samples, PEDALS_MAX_RECORDS);
+    }
+
+    if (n == 0) {
+        stats.pedal_invalid++;
+        ESP_LOGD(TAG, "Pacote de pedais inválido (%u bytes)", (unsigned)len);
+        return;
+    }
+    pedal_samples(samples, n, t_us);
+}
+
+void input_get_stats(input_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Decodificação e mapeamento dos pacotes BLE para o gamepad, chamados pela
+// task do pipeline (pipeline_handler_t). Só dependem do gamepad, dos pedais
+// e dos protocolos, para poderem ser compilados fora do alvo.
+
+typedef struct {
+    uint32_t steering_packets;
+    uint32_t steering_invalid; // Nem binário nem texto com token válido
+    uint32_t pedal_packets;
+    uint32_t pedal_invalid;    // Tamanho incompatível com os dois formatos
+    uint32_t unknown_ids;      // Amostras com ID de pedal desconhecido
+} input_stats_t;
+
+// Volante: formato binário (steering_protocol.h) ou texto "bXX:V;..."
+void input_steering(const uint8_t *data, size_t len, int64_t t_us);
+
+// Pedais: lote com timestamps (pedals_protocol.h) ou registros de 3 bytes.
+// Registros sem timestamp usam t_us, o instante de chegada no host BLE.
+void input_pedals(const uint8_t *data, size_t len, int64_t t_us);
+
+// Leitura informativa de outra task
+void input_get_stats(input_stats_t *out);
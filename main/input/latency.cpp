@@ -0,0 +1,101 @@
+#include "latency.h"
+#include <atomic>
+
+// 0..15 µs exatos, depois 8 faixas por potência de 2 até 2^21 µs
+#define EXACT_BUCKETS 16
+#define SUB_BUCKETS 8
+#define MAX_EXP 20
+#define BUCKETS (EXACT_BUCKETS + (MAX_EXP - 4 + 1) * SUB_BUCKETS)
+
+typedef struct {
+    uint32_t gen;   // Geração de reset já aplicada
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[BUCKETS];
+} histogram_t;
+
+static histogram_t hist[LATENCY_STAGE_COUNT];
+static std::atomic<uint32_t> reset_gen{1};
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    "decode", "schedule", "transfer", "total",
+};
+
+static inline int bucket_of(uint32_t us)
+{
+    if (us < EXACT_BUCKETS) return (int)us;
+    int e = 31 - __builtin_clz(us);
+    if (e > MAX_EXP) return BUCKETS - 1;
+    return EXACT_BUCKETS + (e - 4) * SUB_BUCKETS + (int)((us >> (e - 3)) & (SUB_BUCKETS - 1));
+}
+
+// Limite superior da faixa: percentis são reportados de forma conservadora
+static uint32_t bucket_upper(int b)
+{
+    if (b < EXACT_BUCKETS) return (uint32_t)b;
+    int e = (b - EXACT_BUCKETS) / SUB_BUCKETS + 4;
+    int sub = (b - EXACT_BUCKETS) % SUB_BUCKETS;
+    return ((uint32_t)(SUB_BUCKETS + sub + 1) << (e - 3)) - 1;
+}
+
+static void clear(histogram_t *h, uint32_t gen)
+{
+    *h = {};
+    h->min_us = UINT32_MAX;
+    h->gen = gen;
+}
+
+void latency_record(latency_stage_t stage, uint32_t us)
+{
+    histogram_t *h = &hist[stage];
+    uint32_t gen = reset_gen.load(std::memory_order_acquire);
+    if (h->gen != gen) clear(h, gen);
+
+    h->count++;
+    h->sum_us += us;
+    if (us < h->min_us) h->min_us = us;
+    if (us > h->max_us) h->max_us = us;
+    h->buckets[bucket_of(us)]++;
+}
+
+static uint32_t percentile(const histogram_t *h, uint32_t count, uint32_t per_mille)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)count * per_mille + 999) / 1000);
+    uint32_t acc = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        acc += h->buckets[b];
+        if (acc >= rank) {
+            uint32_t upper = bucket_upper(b);
+            return upper < h->max_us ? upper : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+// Leitura de outra task; pode misturar amostras em andamento
+void latency_get_summary(latency_stage_t stage, latency_summary_t *out)
+{
+    const histogram_t *h = &hist[stage];
+    *out = {};
+    if (h->gen != reset_gen.load(std::memory_order_acquire) || h->count == 0) return;
+
+    uint32_t count = h->count;
+    out->count = count;
+    out->min_us = h->min_us;
+    out->max_us = h->max_us;
+    out->avg_us = (uint32_t)(h->sum_us / count);
+    out->p50_us = percentile(h, count, 500);
+    out->p99_us = percentile(h, count, 990);
+}
+
+void latency_reset()
+{
+    reset_gen.fetch_add(1, std::memory_order_release);
+}
+
+const char *latency_stage_name(latency_stage_t stage)
+{
+    return stage < LATENCY_STAGE_COUNT ? stage_names[stage] : "?";
+}
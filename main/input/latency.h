@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// Latência fim a fim, escrita BLE -> conclusão do IN do USB, por estágio.
+// Cada estágio é um histograma log-linear (8 sub-faixas por potência de 2,
+// erro relativo <= 12,5%) com um único escritor; a leitura é informativa.
+
+typedef enum {
+    LATENCY_DECODE = 0,   // Chegada BLE -> snapshot publicado (fila + decodificação)
+    LATENCY_SCHEDULE,     // Snapshot publicado -> tud_hid_report
+    LATENCY_TRANSFER,     // tud_hid_report -> report complete (poll do host)
+    LATENCY_TOTAL,        // Chegada BLE -> report complete
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_summary_t;
+
+void latency_record(latency_stage_t stage, uint32_t us);
+void latency_get_summary(latency_stage_t stage, latency_summary_t *out);
+void latency_reset(); // Aplicado por cada escritor na próxima amostra
+const char *latency_stage_name(latency_stage_t stage);
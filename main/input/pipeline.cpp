@@ -0,0 +1,213 @@
+#include "pipeline.h"
+#include "capture.h"
+#include <atomic>
+#include <cstring>
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+}
+
+static const char *TAG = "PIPELINE";
+
+#ifdef CONFIG_POLILANTE_PIPELINE_RING_SIZE
+#define RING_SIZE CONFIG_POLILANTE_PIPELINE_RING_SIZE
+#define TASK_CORE CONFIG_POLILANTE_PIPELINE_CORE
+#define TASK_PRIO CONFIG_POLILANTE_PIPELINE_PRIORITY
+#else
+#define RING_SIZE 4096
+#define TASK_CORE 1
+#define TASK_PRIO 10
+#endif
+#define TASK_STACK 4096
+
+// Eventos de replay (input/capture.h) têm produtor próprio: ring separado,
+// para cada ring continuar com um único produtor
+#define REPLAY_RING_SIZE 1024
+
+static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "ring do pipeline deve ser potência de 2");
+
+// Registro no ring: cabeçalho + payload, alinhado em 4 bytes.
+// len == REC_WRAP marca o fim do buffer: o próximo registro começa no índice 0.
+typedef struct {
+    uint16_t len;
+    uint8_t source;
+    uint8_t flags;   // PIPELINE_FLAG_*
+    int64_t t_us;
+} rec_hdr_t;
+
+#define REC_WRAP 0xFFFF
+#define REC_ALIGN(n) (((n) + 3) & ~3u)
+
+// Ring SPSC de registros de tamanho variável
+template <uint32_t SIZE>
+struct spsc_ring {
+    static constexpr uint32_t MASK = SIZE - 1;
+    uint8_t buf[SIZE] __attribute__((aligned(8)));
+    std::atomic<uint32_t> head{0};  // Escrito só pelo produtor
+    std::atomic<uint32_t> tail{0};  // Escrito só pelo consumidor
+    uint32_t max_depth = 0;
+
+    bool push(const rec_hdr_t *hdr, const void *data)
+    {
+        uint32_t need = REC_ALIGN(sizeof(rec_hdr_t) + hdr->len);
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        uint32_t off = h & MASK;
+        uint32_t contiguous = SIZE - off;
+        uint32_t total = need > contiguous ? contiguous + need : need;
+
+        if (need > SIZE / 2 || SIZE - (h - t) < total) return false;
+
+        if (need > contiguous) {
+            uint16_t wrap = REC_WRAP;
+            memcpy(&buf[off], &wrap, sizeof(wrap));
+            h += contiguous;
+            off = 0;
+        }
+
+        memcpy(&buf[off], hdr, sizeof(*hdr));
+        memcpy(&buf[off + sizeof(*hdr)], data, hdr->len);
+
+        h += need;
+        head.store(h, std::memory_order_release);
+
+        if (h - t > max_depth) max_depth = h - t;
+        return true;
+    }
+
+    // Entrega cada registro a fn com o payload ainda no ring; o espaço só é
+    // liberado depois que fn retorna
+    template <typename F>
+    uint32_t drain(F fn)
+    {
+        uint32_t n = 0;
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        while (t != h) {
+            uint32_t off = t & MASK;
+            uint16_t len;
+            memcpy(&len, &buf[off], sizeof(len));
+
+            if (len == REC_WRAP) {
+                t += SIZE - off;
+                continue;
+            }
+
+            rec_hdr_t hdr;
+            memcpy(&hdr, &buf[off], sizeof(hdr));
+            fn(hdr, &buf[off + sizeof(hdr)]);
+
+            t += REC_ALIGN(sizeof(rec_hdr_t) + hdr.len);
+            tail.store(t, std::memory_order_release);
+            n++;
+        }
+        tail.store(t, std::memory_order_release);
+        return n;
+    }
+
+    uint32_t depth()
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+};
+
+static spsc_ring<RING_SIZE> live;
+static spsc_ring<REPLAY_RING_SIZE> replay;
+
+static pipeline_handler_t handlers[2] = {NULL, NULL};
+static TaskHandle_t task = NULL;
+
+static uint32_t pushed = 0;
+static uint32_t dropped = 0;
+static std::atomic<uint32_t> processed{0};
+
+static void push(pipeline_source_t source, const char *data, size_t len)
+{
+    rec_hdr_t hdr = {};
+    hdr.len = (uint16_t)len;
+    hdr.source = source;
+    hdr.t_us = esp_timer_get_time();
+
+    if (!live.push(&hdr, data)) {
+        dropped++;
+        return;
+    }
+    pushed++;
+
+    if (task) xTaskNotifyGive(task);
+}
+
+void pipeline_push_steering(const char *data, size_t len)
+{
+    push(PIPELINE_SRC_STEERING, data, len);
+}
+
+void pipeline_push_pedals(const char *data, size_t len)
+{
+    push(PIPELINE_SRC_PEDALS, data, len);
+}
+
+bool pipeline_push_replay(pipeline_source_t source, const uint8_t *data, size_t len,
+                          int64_t t_us, uint8_t flags)
+{
+    rec_hdr_t hdr = {};
+    hdr.len = (uint16_t)len;
+    hdr.source = source;
+    hdr.flags = flags | PIPELINE_FLAG_REPLAY;
+    hdr.t_us = t_us;
+
+    if (!replay.push(&hdr, data)) return false;
+    if (task) xTaskNotifyGive(task);
+    return true;
+}
+
+static void dispatch(const rec_hdr_t &hdr, const uint8_t *data)
+{
+    if (!capture_before_event((pipeline_source_t)hdr.source, data, hdr.len, hdr.t_us, hdr.flags)) {
+        return;
+    }
+
+    pipeline_handler_t handler = handlers[hdr.source];
+    if (handler) handler(data, hdr.len, hdr.t_us);
+
+    if (hdr.flags & PIPELINE_FLAG_REPLAY) capture_after_replay(hdr.flags);
+}
+
+static void pipeline_task(void *)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t n = live.drain(dispatch);
+        n += replay.drain(dispatch);
+        processed.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+void pipeline_init(pipeline_handler_t steering, pipeline_handler_t pedals)
+{
+    handlers[PIPELINE_SRC_STEERING] = steering;
+    handlers[PIPELINE_SRC_PEDALS] = pedals;
+
+    if (xTaskCreatePinnedToCore(pipeline_task, "Input_Pipeline", TASK_STACK, NULL,
+                                TASK_PRIO, &task, TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar task do pipeline");
+        return;
+    }
+    ESP_LOGI(TAG, "Pipeline no core %d, prioridade %d, ring de %d bytes",
+             TASK_CORE, TASK_PRIO, RING_SIZE);
+}
+
+// Contadores do produtor lidos de outra task: valores informativos
+void pipeline_get_stats(pipeline_stats_t *out)
+{
+    out->pushed = pushed;
+    out->processed = processed.load(std::memory_order_relaxed);
+    out->dropped = dropped;
+    out->depth = live.depth();
+    out->max_depth = live.max_depth;
+    out->capacity = RING_SIZE;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Pipeline de entrada: os callbacks GATT só copiam o payload para um ring
+// SPSC lock-free; uma task dedicada faz decodificação, filtro, mapeamento e
+// publicação no gamepad. Assim a task do host NimBLE nunca espera por log
+// ou processamento.
+
+typedef enum {
+    PIPELINE_SRC_STEERING = 0,
+    PIPELINE_SRC_PEDALS,
+} pipeline_source_t;
+
+// Flags de um evento
+#define PIPELINE_FLAG_REPLAY       0x01  // Vem do replay de uma captura
+#define PIPELINE_FLAG_REPLAY_FIRST 0x02  // Primeiro evento do replay
+#define PIPELINE_FLAG_REPLAY_LAST  0x04  // Último evento do replay
+
+// Chamado na task do pipeline; data aponta para dentro do ring (válido só durante a chamada)
+typedef void (*pipeline_handler_t)(const uint8_t *data, size_t len, int64_t t_us);
+
+typedef struct {
+    uint32_t pushed;      // Eventos enfileirados
+    uint32_t processed;   // Eventos entregues aos handlers
+    uint32_t dropped;     // Eventos descartados por ring cheio
+    uint32_t depth;       // Bytes ocupados no ring agora
+    uint32_t max_depth;   // Maior ocupação observada
+    uint32_t capacity;    // Tamanho do ring em bytes
+} pipeline_stats_t;
+
+void pipeline_init(pipeline_handler_t steering, pipeline_handler_t pedals);
+
+// Produtores (task do host NimBLE), com a assinatura de ble_rx_callback_t
+void pipeline_push_steering(const char *data, size_t len);
+void pipeline_push_pedals(const char *data, size_t len);
+
+// Produtor do replay (task de replay da captura); false com o ring cheio
+bool pipeline_push_replay(pipeline_source_t source, const uint8_t *data, size_t len,
+                          int64_t t_us, uint8_t flags);
+
+void pipeline_get_stats(pipeline_stats_t *out);
@@ -1,149 +1,201 @@
 #include "usb/descriptor.h"
 #include "usb/gamepad.h"
 #include "usb/cdc.h"
+#include "pedals/calibration.h"
+#include "pedals/curve.h"
+#include "pedals/filter.h"
+#include "haptics/haptics.h"
+#include "input/pipeline.h"
+#include "input/handlers.h"
+#include "input/capture.h"
+#include "input/latency.h"
+#include "telemetry/telemetry.h"
+#include "console/commands.h"
 #include "esp_log.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 
 extern "C" {
     #include "freertos/FreeRTOS.h"
     #include "freertos/task.h"
+    #include "esp_timer.h"
     #include "tinyusb.h" 
     #include "ble/ble.h"
+#ifdef CONFIG_POLILANTE_PARSER_BENCH
+    #include "esp_cpu.h"
+    #include "ble/steering_protocol.h"
+    #include "ble/pedals_protocol.h"
+#endif
 }
 
 
 static const char *TAG = "MAIN";
 
-#define MIN_HALL 1860
-#define MAX_HALL 3000
 
+void my_cdc_rx_handler(const uint8_t* data, size_t len)
+{
+    // Upload de captura: quadros COBS até o quadro de fim
+    if (capture_loading()) {
+        capture_load_frame(data, len);
+        return;
+    }
+
+    // Linha completa, já terminada em '\0' no buffer da CDC
+    const char *line = (const char *)data;
+
+    if (console_command(line)) return;
+
+    cdc_printf("Recebido: %s\r\n", line);
 
-static int8_t map_value(int value) {
-    // Garante que o valor esteja dentro do intervalo
-    if (value < MIN_HALL) value = MIN_HALL;
-    if (value > MAX_HALL) value = MAX_HALL;
+    ESP_LOGI("COM", "%s", line);
 
-    // Regra de 3: (value - MIN) * 254 / (MAX - MIN) - 127
-    int mapped = ((value - MIN_HALL) * 254) / (MAX_HALL - MIN_HALL) - 127;
-    return (int8_t)mapped;
+    ble_send_pedals(line, len);
 }
 
 
-void my_cdc_rx_handler(const uint8_t* data, size_t len)
-{
-    // Cria um buffer temporário, garante espaço para o terminador
-    char temp[65];
-    size_t copy_len = (len < 64) ? len : 64;
-    memcpy(temp, data, copy_len);
-    temp[copy_len] = '\0'; // Garante string terminada
+#ifdef CONFIG_POLILANTE_HAPTICS_TEST
+// Task dedicada para envio BLE SOMENTE TESTE
+void ble_vibration_task(void *pvParameters) {
+    srand((unsigned int)time(NULL));
+
+    vTaskDelay(pdMS_TO_TICKS(10000)); 
 
-    cdc_send_text("Recebido: ");
-    cdc_send_text(temp);
-    cdc_send_text("\r\n");
+    while (true) {
+        for (uint8_t motor_id = 0x01; motor_id <= 0x03; motor_id++) {
+            uint8_t vibration = rand() % 101;
+            haptics_set(motor_id, vibration);
 
-    ESP_LOGI("COM", "%s", temp);
+            vTaskDelay(pdMS_TO_TICKS(100));  // Pequeno delay entre motores
+        }
 
-    ble_send_pedals(temp,  copy_len);
+        vTaskDelay(pdMS_TO_TICKS(1000));  // Delay entre ciclos
+    }
 }
+#endif
+
+
+#ifdef CONFIG_POLILANTE_LATENCY_BENCH
+// Benchmark: latência escrita BLE -> report USB no intervalo de polling configurado
+static void latency_bench_task(void *pvParameters) {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(5000));
 
+        char line[96];
+        for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+            console_format_latency((latency_stage_t)i, line, sizeof(line));
+            ESP_LOGI(TAG, "Latência @%d ms: %s", HID_POLL_INTERVAL_MS, line);
+        }
+        latency_reset();
 
-static void steering_cb(const char *data, size_t len) {
-    ESP_LOGI(TAG, "STEERING callback: %.*s", (int)len, data);
+        pipeline_stats_t ps;
+        pipeline_get_stats(&ps);
+        ESP_LOGI(TAG, "Pipeline: %lu eventos, %lu descartados, pico %lu/%lu bytes",
+                 (unsigned long)ps.processed, (unsigned long)ps.dropped,
+                 (unsigned long)ps.max_depth, (unsigned long)ps.capacity);
+    }
+}
+#endif
 
+#ifdef CONFIG_POLILANTE_PARSER_BENCH
+// Parser texto antigo (strtok/sscanf), só para comparação
+static uint16_t __attribute__((noinline)) steering_text_libc(const uint8_t *data, size_t len)
+{
     char buf[128];
     if (len >= sizeof(buf)) len = sizeof(buf) - 1;
     memcpy(buf, data, len);
     buf[len] = '\0';
 
-    // Divide pelos ";"
-    char *token = strtok(buf, ";");
-    while (token != NULL) {
+    uint16_t pressed = 0;
+    for (char *token = strtok(buf, ";"); token != NULL; token = strtok(NULL, ";")) {
         char key[8];
         int value;
-
-        // Esperado: bXX:0 ou bXX:1
-        if (sscanf(token, "%3[^:]:%d", key, &value) == 2) {
-            if (key[0] == 'b') {
-                int button = atoi(&key[1]);  // pega número após 'b'
-                if (button >= 0 && button <= 15) {
-                    if (value == 1) {
-                        gamepad_press((uint8_t)button);
-                        ESP_LOGI(TAG, "Button %d pressed", button);
-                    } else {
-                        gamepad_release((uint8_t)button);
-                        ESP_LOGI(TAG, "Button %d released", button);
-                    }
-                }
-            }
+        if (sscanf(token, "%3[^:]:%d", key, &value) == 2 && key[0] == 'b') {
+            int button = atoi(&key[1]);
+            if (button >= 0 && button <= 15 && value == 1) pressed |= 1 << button;
         }
-
-        token = strtok(NULL, ";");
     }
+    return pressed;
 }
 
-static void pedals_cb(const char *data, size_t len) {
-    if (len % 3 != 0) {
-        ESP_LOGW(TAG, "Pacote inválido: tamanho não múltiplo de 3");
-        return;
+// Benchmark: ciclos por pacote de cada decodificador de entrada BLE
+static void parser_benchmark()
+{
+    static const uint8_t steering_bin[] = {STEERING_BIN_MAGIC, 0x05, 0x00, 0x0F, 0x00, 0x02};
+    static const char steering_txt[] = "b0:1;b2:1;b1:0;b3:0;b15:1";
+    uint8_t records[PEDALS_RECORD_LEN * 3] = {0x01, 0x08, 0x00, 0x02, 0x09, 0x00, 0x03, 0x0A, 0x00};
+    uint8_t batch[PEDALS_BATCH_HEADER_LEN + PEDALS_BATCH_SAMPLE_LEN * 12] = {PEDALS_BATCH_MAGIC};
+    for (int i = 0; i < 12; i++) {
+        uint8_t *p = &batch[PEDALS_BATCH_HEADER_LEN + i * PEDALS_BATCH_SAMPLE_LEN];
+        p[0] = 1 + i % 3;
+        p[2] = (uint8_t)(i * 250 / 3);
+        p[3] = 0x08;
     }
 
-    for (size_t i = 0; i < len; i += 3) {
-        uint8_t id = data[i];
-        uint16_t raw = ((uint8_t)data[i + 1] << 8) | (uint8_t)data[i + 2];
-        int8_t mapped = map_value(raw);  // Mapeia para -127 a 127, por exemplo
-
-        switch (id) {
-            case 0x01:  // ACC
-                gamepad_set_x(mapped);
-                //ESP_LOGI(TAG, "ACC: %d", raw);
-                break;
-            case 0x02:  // BRK
-                gamepad_set_y(mapped);
-               // ESP_LOGI(TAG, "BRK: %d", raw);
-                break;
-            case 0x03:  // THT
-                gamepad_set_z(mapped);
-               // ESP_LOGI(TAG, "THT: %d", raw);
-                break;
-            default:
-                ESP_LOGW(TAG, "ID desconhecido: 0x%02X", id);
-                break;
-        }
-    }
-}
+    const int iters = 10000;
+    volatile uint32_t sink = 0;
+    steering_bin_t bin;
+    pedals_sample_t samples[PEDALS_MAX_RECORDS];
+    uint32_t cycles[5];
 
-// Task dedicada para envio BLE SOMENTE TESTE
-void ble_vibration_task(void *pvParameters) {
-    srand((unsigned int)time(NULL));
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iters; i++) sink += steering_decode_binary(steering_bin, sizeof(steering_bin), &bin);
+    cycles[0] = esp_cpu_get_cycle_count() - t0;
 
-    vTaskDelay(pdMS_TO_TICKS(10000)); 
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iters; i++) {
+        sink += steering_decode_text((const uint8_t *)steering_txt, sizeof(steering_txt) - 1, &bin);
+    }
+    cycles[1] = esp_cpu_get_cycle_count() - t0;
 
-    while (true) {
-        for (uint8_t motor_id = 0x01; motor_id <= 0x03; motor_id++) {
-            uint8_t vibration = rand() % 101;
-            int result = ble_send_pedal_vibration(motor_id, vibration);
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iters; i++) sink += steering_text_libc((const uint8_t *)steering_txt, sizeof(steering_txt) - 1);
+    cycles[2] = esp_cpu_get_cycle_count() - t0;
 
-            vTaskDelay(pdMS_TO_TICKS(100));  // Pequeno delay entre motores
-        }
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iters; i++) sink += pedals_decode_records(records, sizeof(records), i, samples, PEDALS_MAX_RECORDS);
+    cycles[3] = esp_cpu_get_cycle_count() - t0;
 
-        vTaskDelay(pdMS_TO_TICKS(1000));  // Delay entre ciclos
-    }
-}
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iters; i++) sink += pedals_decode_batch(batch, sizeof(batch), samples, PEDALS_BATCH_MAX_SAMPLES);
+    cycles[4] = esp_cpu_get_cycle_count() - t0;
 
+    ESP_LOGI(TAG, "Parsers (ciclos/pacote): steering bin %lu, texto %lu (libc %lu), pedais 3 reg. %lu, lote 12 am. %lu",
+             (unsigned long)(cycles[0] / iters), (unsigned long)(cycles[1] / iters),
+             (unsigned long)(cycles[2] / iters), (unsigned long)(cycles[3] / iters),
+             (unsigned long)(cycles[4] / iters));
+}
+#endif
 
 extern "C" void app_main(void)
 {
     usb_init();
     cdc_set_rx_callback(my_cdc_rx_handler);
 
-    ble_init(steering_cb, pedals_cb);
+    capture_init();
+    pipeline_init(input_steering, input_pedals);
+    ble_init(pipeline_push_steering, pipeline_push_pedals);
+    calibration_init(); // Depende da NVS inicializada em ble_init
+    filter_init();
 
 
+    haptics_init();
+    telemetry_init();
+
+#ifdef CONFIG_POLILANTE_HAPTICS_TEST
     xTaskCreate(ble_vibration_task, "BLE_Vibration_Task", 4096, NULL, 5, NULL);
+#endif
+
+#ifdef CONFIG_POLILANTE_PARSER_BENCH
+    parser_benchmark();
+#endif
+
+#ifdef CONFIG_POLILANTE_LATENCY_BENCH
+    xTaskCreate(latency_bench_task, "Latency_Bench", 3072, NULL, 1, NULL);
+#endif
 
 
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "calibration.h"
+#include "curve.h"
+#include "usb/gamepad.h"
+#include <atomic>
+#include <math.h>
+extern "C" {
+#include "esp_cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+}
+
+static const char *TAG = "CAL";
+
+#define NVS_NAMESPACE "pedals"
+#define NVS_KEY       "cal"
+#define CAL_VERSION   1
+
+// Só reconstrói a tabela quando o auto-range avança pelo menos isso
+#define AUTO_RANGE_STEP 4
+// Intervalo entre gravações do auto-range na NVS
+#define AUTO_RANGE_SAVE_MS 30000
+
+typedef struct {
+    uint8_t version;
+    pedal_calibration_t pedals[PEDAL_COUNT];
+} calibration_blob_t;
+
+// Escrita só com o lock (task da calibração e comandos); o pipeline só lê
+static pedal_calibration_t cal[PEDAL_COUNT];
+static SemaphoreHandle_t lock = NULL;
+
+// Valor bruto -> eixo, já com clamp, deadzones e curva de resposta
+static int16_t lut[PEDAL_COUNT][PEDAL_RAW_RANGE];
+
+// Extremos do auto-range vistos pelo pipeline. A task da calibração os
+// aplica em cal[] e reconstrói a tabela fora do caminho quente.
+static std::atomic<uint16_t> range_min[PEDAL_COUNT];
+static std::atomic<uint16_t> range_max[PEDAL_COUNT];
+static TaskHandle_t task = NULL;
+
+static void calibration_defaults(pedal_calibration_t *c)
+{
+    c->min = CALIBRATION_DEFAULT_MIN;
+    c->max = CALIBRATION_DEFAULT_MAX;
+    c->deadzone_low = 0;
+    c->deadzone_high = 0;
+    c->auto_range = false;
+}
+
+static bool calibration_valid(const pedal_calibration_t *c)
+{
+    return c->max < PEDAL_RAW_RANGE && c->min < c->max &&
+           c->deadzone_low + c->deadzone_high < c->max - c->min;
+}
+
+static void build_lut(pedal_t pedal)
+{
+    const pedal_calibration_t *c = &cal[pedal];
+    int32_t lo = c->min + c->deadzone_low;
+    int32_t hi = c->max - c->deadzone_high;
+    int32_t span = hi - lo;
+
+    for (int32_t raw = 0; raw < PEDAL_RAW_RANGE; raw++) {
+        int32_t v = raw;
+        if (v < lo) v = lo;
+        if (v > hi) v = hi;
+        uint32_t pos = (uint32_t)(v - lo) * CURVE_MAX / span;
+        uint32_t out = curve_map(pedal, pos);
+        lut[pedal][raw] = (int16_t)((int32_t)(out * (GAMEPAD_AXIS16_MAX - GAMEPAD_AXIS16_MIN) / CURVE_MAX)
+                                    + GAMEPAD_AXIS16_MIN);
+    }
+}
+
+void calibration_rebuild(pedal_t pedal)
+{
+    if (pedal >= PEDAL_COUNT) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    build_lut(pedal);
+    xSemaphoreGive(lock);
+}
+
+#ifdef CONFIG_POLILANTE_CURVE_BENCH
+// Mapeamento aritmético antigo (clamp + regra de 3 + gamma), só para comparação
+static int16_t __attribute__((noinline)) map_arith(uint16_t raw, float gamma)
+{
+    int32_t v = raw;
+    if (v < CALIBRATION_DEFAULT_MIN) v = CALIBRATION_DEFAULT_MIN;
+    if (v > CALIBRATION_DEFAULT_MAX) v = CALIBRATION_DEFAULT_MAX;
+    float x = (float)(v - CALIBRATION_DEFAULT_MIN) / (CALIBRATION_DEFAULT_MAX - CALIBRATION_DEFAULT_MIN);
+    return (int16_t)(powf(x, gamma) * (GAMEPAD_AXIS16_MAX - GAMEPAD_AXIS16_MIN) + GAMEPAD_AXIS16_MIN);
+}
+
+// Benchmark: ciclos por amostra da tabela contra o cálculo direto
+static void calibration_benchmark()
+{
+    const int samples = PEDAL_RAW_RANGE * 4;
+    volatile int32_t sink = 0;
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < samples; i++) sink += calibration_apply(PEDAL_BRK, i & (PEDAL_RAW_RANGE - 1));
+    uint32_t t1 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < samples; i++) sink += map_arith(i & (PEDAL_RAW_RANGE - 1), 2.2f);
+    uint32_t t2 = esp_cpu_get_cycle_count();
+
+    ESP_LOGI(TAG, "Benchmark: tabela %lu ciclos/amostra, aritmético %lu ciclos/amostra",
+             (unsigned long)((t1 - t0) / samples), (unsigned long)((t2 - t1) / samples));
+}
+#endif
+
+// Com o lock
+static esp_err_t save_locked()
+{
+    calibration_blob_t blob = {};
+    blob.version = CAL_VERSION;
+    for (int i = 0; i < PEDAL_COUNT; i++) blob.pedals[i] = cal[i];
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+
+    err = nvs_set_blob(nvs, NVS_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao salvar calibração: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t calibration_save()
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    esp_err_t err = save_locked();
+    xSemaphoreGive(lock);
+    return err;
+}
+
+// Com o lock: o auto-range recomeça da calibração atual
+static void reset_range(pedal_t pedal)
+{
+    range_min[pedal].store(cal[pedal].min, std::memory_order_relaxed);
+    range_max[pedal].store(cal[pedal].max, std::memory_order_relaxed);
+}
+
+static void calibration_load()
+{
+    for (int i = 0; i < PEDAL_COUNT; i++) calibration_defaults(&cal[i]);
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        ESP_LOGI(TAG, "Sem calibração salva, usando padrão");
+        return;
+    }
+
+    calibration_blob_t blob;
+    size_t size = sizeof(blob);
+    esp_err_t err = nvs_get_blob(nvs, NVS_KEY, &blob, &size);
+    nvs_close(nvs);
+
+    if (err != ESP_OK || size != sizeof(blob) || blob.version != CAL_VERSION) {
+        ESP_LOGW(TAG, "Calibração salva ausente ou incompatível, usando padrão");
+        return;
+    }
+
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        if (calibration_valid(&blob.pedals[i])) {
+            cal[i] = blob.pedals[i];
+        } else {
+            ESP_LOGW(TAG, "Calibração do pedal %d inválida, usando padrão", i);
+        }
+    }
+}
+
+// Aplica os extremos novos; retorna true se algum pedal mudou
+static bool apply_auto_range()
+{
+    bool changed = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        pedal_calibration_t *c = &cal[i];
+        uint16_t lo = range_min[i].load(std::memory_order_relaxed);
+        uint16_t hi = range_max[i].load(std::memory_order_relaxed);
+        if (!c->auto_range || (lo == c->min && hi == c->max)) continue;
+
+        pedal_calibration_t next = *c;
+        next.min = lo;
+        next.max = hi;
+        if (!calibration_valid(&next)) continue;
+        *c = next;
+        build_lut((pedal_t)i);
+        changed = true;
+    }
+    xSemaphoreGive(lock);
+    return changed;
+}
+
+// Reconstrói as tabelas quando o pipeline avisa de um extremo novo e grava
+// na NVS no máximo a cada AUTO_RANGE_SAVE_MS
+static void calibration_task(void *)
+{
+    const TickType_t save_period = pdMS_TO_TICKS(AUTO_RANGE_SAVE_MS);
+    TickType_t last_save = xTaskGetTickCount() - save_period;
+    bool dirty = false;
+
+    while (true) {
+        TickType_t wait = portMAX_DELAY;
+        if (dirty) {
+            TickType_t elapsed = xTaskGetTickCount() - last_save;
+            wait = elapsed >= save_period ? 0 : save_period - elapsed;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        dirty |= apply_auto_range();
+        if (dirty && xTaskGetTickCount() - last_save >= save_period) {
+            calibration_save();
+            last_save = xTaskGetTickCount();
+            dirty = false;
+        }
+    }
+}
+
+void calibration_init()
+{
+    lock = xSemaphoreCreateMutex();
+    calibration_load();
+    curve_init();
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        reset_range((pedal_t)i);
+        build_lut((pedal_t)i);
+        ESP_LOGI(TAG, "Pedal %d: min=%u max=%u dz=%u/%u auto=%d", i,
+                 cal[i].min, cal[i].max, cal[i].deadzone_low, cal[i].deadzone_high, cal[i].auto_range);
+    }
+
+    xTaskCreate(calibration_task, "Cal", 3072, NULL, 1, &task);
+
+#ifdef CONFIG_POLILANTE_CURVE_BENCH
+    calibration_benchmark();
+#endif
+}
+
+void calibration_get(pedal_t pedal, pedal_calibration_t *out)
+{
+    if (pedal >= PEDAL_COUNT) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    *out = cal[pedal];
+    xSemaphoreGive(lock);
+}
+
+// A tabela é reconstruída no lugar: durante a reconstrução uma leitura
+// concorrente pode pegar um valor da calibração antiga, nunca um valor inválido
+esp_err_t calibration_set(pedal_t pedal, const pedal_calibration_t *c)
+{
+    if (pedal >= PEDAL_COUNT || !calibration_valid(c)) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    cal[pedal] = *c;
+    reset_range(pedal);
+    build_lut(pedal);
+    esp_err_t err = save_locked();
+    xSemaphoreGive(lock);
+    return err;
+}
+
+int16_t calibration_apply(pedal_t pedal, uint16_t raw)
+{
+    if (raw >= PEDAL_RAW_RANGE) raw = PEDAL_RAW_RANGE - 1;
+
+    // Auto-range: só registra o extremo e acorda a task da calibração
+    if (cal[pedal].auto_range) {
+        if (raw + AUTO_RANGE_STEP <= range_min[pedal].load(std::memory_order_relaxed)) {
+            range_min[pedal].store(raw, std::memory_order_relaxed);
+            if (task) xTaskNotifyGive(task);
+        } else if (raw >= range_max[pedal].load(std::memory_order_relaxed) + AUTO_RANGE_STEP) {
+            range_max[pedal].store(raw, std::memory_order_relaxed);
+            if (task) xTaskNotifyGive(task);
+        }
+    }
+
+    return lut[pedal][raw];
+}
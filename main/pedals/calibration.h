@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include "esp_err.h"
+
+// Pedais na ordem dos IDs do protocolo BLE (0x01, 0x02, 0x03)
+typedef enum {
+    PEDAL_ACC = 0,
+    PEDAL_BRK,
+    PEDAL_THT,
+    PEDAL_COUNT
+} pedal_t;
+
+// Domínio do valor bruto do sensor hall (ADC de 12 bits)
+#define PEDAL_RAW_RANGE 4096
+
+// Faixa padrão até haver calibração salva
+#define CALIBRATION_DEFAULT_MIN 1860
+#define CALIBRATION_DEFAULT_MAX 3000
+
+typedef struct {
+    uint16_t min;            // Valor bruto em repouso
+    uint16_t max;            // Valor bruto no fim do curso
+    uint16_t deadzone_low;   // Contagens acima de min tratadas como repouso
+    uint16_t deadzone_high;  // Contagens abaixo de max tratadas como fim de curso
+    bool auto_range;         // Expande min/max com os extremos observados
+} pedal_calibration_t;
+
+// Carrega a calibração da NVS (já inicializada em ble_init) e monta as tabelas
+void calibration_init();
+
+void calibration_get(pedal_t pedal, pedal_calibration_t *out);
+// Aplica, reconstrói a tabela do pedal e persiste na NVS
+esp_err_t calibration_set(pedal_t pedal, const pedal_calibration_t *cal);
+// Persiste já o estado atual (inclusive o auto-range ainda não gravado)
+esp_err_t calibration_save();
+// Remonta a tabela do pedal (calibração + curva de resposta)
+void calibration_rebuild(pedal_t pedal);
+
+// Valor bruto -> eixo de 16 bits (-32767 até 32767) por leitura de tabela,
+// já com a curva de resposta do pedal aplicada. Com auto-range, um extremo
+// novo só é registrado: a task da calibração reconstrói a tabela depois.
+// Chamado só pelo produtor do gamepad (task do pipeline).
+int16_t calibration_apply(pedal_t pedal, uint16_t raw);
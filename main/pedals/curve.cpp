@@ -0,0 +1,178 @@
+#include "curve.h"
+#include <math.h>
+extern "C" {
+#include "esp_log.h"
+#include "nvs.h"
+}
+
+static const char *TAG = "CURVE";
+
+#define NVS_NAMESPACE "pedals"
+#define NVS_KEY       "curve"
+#define CURVE_VERSION 1
+
+// 256 segmentos: o byte alto da posição indexa, o baixo interpola
+#define CURVE_TABLE_SHIFT 8
+#define CURVE_TABLE_SIZE  ((CURVE_MAX >> CURVE_TABLE_SHIFT) + 2)
+
+typedef struct {
+    uint8_t version;
+    pedal_curve_t pedals[PEDAL_COUNT];
+} curve_blob_t;
+
+static pedal_curve_t curves[PEDAL_COUNT];
+static uint16_t table[PEDAL_COUNT][CURVE_TABLE_SIZE];
+
+static bool curve_valid(const pedal_curve_t *c)
+{
+    switch (c->type) {
+        case CURVE_LINEAR:
+            return true;
+        case CURVE_GAMMA:
+            return c->gamma_x100 >= 10 && c->gamma_x100 <= 1000;
+        case CURVE_SCURVE:
+            return c->scurve <= 100;
+        case CURVE_SPLINE:
+            for (int i = 0; i < CURVE_SPLINE_POINTS; i++) {
+                if (c->spline[i] > CURVE_SPLINE_MAX) return false;
+                if (i && c->spline[i] < c->spline[i - 1]) return false; // Pedal deve ser monotônico
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Spline de Hermite monotônica (Fritsch-Carlson) pelos pontos uniformes
+static float spline_eval(const pedal_curve_t *c, float x)
+{
+    const int n = CURVE_SPLINE_POINTS;
+    const float h = 1.0f / (n - 1);
+    float y[CURVE_SPLINE_POINTS], d[CURVE_SPLINE_POINTS - 1], m[CURVE_SPLINE_POINTS];
+
+    for (int i = 0; i < n; i++) y[i] = (float)c->spline[i] / CURVE_SPLINE_MAX;
+    for (int i = 0; i < n - 1; i++) d[i] = (y[i + 1] - y[i]) / h;
+
+    m[0] = d[0];
+    m[n - 1] = d[n - 2];
+    for (int i = 1; i < n - 1; i++) {
+        m[i] = (d[i - 1] * d[i] <= 0.0f) ? 0.0f : (d[i - 1] + d[i]) / 2.0f;
+    }
+    for (int i = 0; i < n - 1; i++) {
+        if (d[i] == 0.0f) {
+            m[i] = m[i + 1] = 0.0f;
+            continue;
+        }
+        float a = m[i] / d[i], b = m[i + 1] / d[i];
+        float s = a * a + b * b;
+        if (s > 9.0f) {
+            float t = 3.0f / sqrtf(s);
+            m[i] = t * a * d[i];
+            m[i + 1] = t * b * d[i];
+        }
+    }
+
+    int k = (int)(x / h);
+    if (k > n - 2) k = n - 2;
+    float t = (x - k * h) / h;
+    float t2 = t * t, t3 = t2 * t;
+    return (2 * t3 - 3 * t2 + 1) * y[k] + (t3 - 2 * t2 + t) * h * m[k] +
+           (-2 * t3 + 3 * t2) * y[k + 1] + (t3 - t2) * h * m[k + 1];
+}
+
+static float curve_eval(const pedal_curve_t *c, float x)
+{
+    switch (c->type) {
+        case CURVE_GAMMA:
+            return powf(x, c->gamma_x100 / 100.0f);
+        case CURVE_SCURVE: {
+            float k = c->scurve / 100.0f;
+            return (1.0f - k) * x + k * x * x * (3.0f - 2.0f * x);
+        }
+        case CURVE_SPLINE:
+            return spline_eval(c, x);
+        default:
+            return x;
+    }
+}
+
+// Ponto flutuante só aqui, fora do caminho de cada amostra
+static void compile(pedal_t pedal)
+{
+    for (int i = 0; i < CURVE_TABLE_SIZE; i++) {
+        float x = (float)(i << CURVE_TABLE_SHIFT) / (CURVE_MAX + 1);
+        if (x > 1.0f) x = 1.0f;
+        float y = curve_eval(&curves[pedal], x);
+        if (y < 0.0f) y = 0.0f;
+        if (y > 1.0f) y = 1.0f;
+        table[pedal][i] = (uint16_t)lroundf(y * CURVE_MAX);
+    }
+}
+
+esp_err_t curve_save()
+{
+    curve_blob_t blob = {};
+    blob.version = CURVE_VERSION;
+    for (int i = 0; i < PEDAL_COUNT; i++) blob.pedals[i] = curves[i];
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+
+    err = nvs_set_blob(nvs, NVS_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao salvar curvas: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void curve_init()
+{
+    for (int i = 0; i < PEDAL_COUNT; i++) curves[i] = {};
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        curve_blob_t blob;
+        size_t size = sizeof(blob);
+        esp_err_t err = nvs_get_blob(nvs, NVS_KEY, &blob, &size);
+        nvs_close(nvs);
+
+        if (err == ESP_OK && size == sizeof(blob) && blob.version == CURVE_VERSION) {
+            for (int i = 0; i < PEDAL_COUNT; i++) {
+                if (curve_valid(&blob.pedals[i])) curves[i] = blob.pedals[i];
+            }
+        }
+    }
+
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        compile((pedal_t)i);
+        ESP_LOGI(TAG, "Pedal %d: curva tipo %d", i, curves[i].type);
+    }
+}
+
+void curve_get(pedal_t pedal, pedal_curve_t *out)
+{
+    if (pedal < PEDAL_COUNT) *out = curves[pedal];
+}
+
+esp_err_t curve_set(pedal_t pedal, const pedal_curve_t *curve)
+{
+    if (pedal >= PEDAL_COUNT || !curve_valid(curve)) return ESP_ERR_INVALID_ARG;
+
+    curves[pedal] = *curve;
+    compile(pedal);
+    calibration_rebuild(pedal);
+    return curve_save();
+}
+
+uint16_t curve_map(pedal_t pedal, uint32_t pos)
+{
+    const uint16_t *t = table[pedal];
+    if (pos >= CURVE_MAX) return t[CURVE_TABLE_SIZE - 1]; // Fim de curso exato
+    uint32_t i = pos >> CURVE_TABLE_SHIFT;
+    uint32_t frac = pos & ((1 << CURVE_TABLE_SHIFT) - 1);
+    return (uint16_t)(t[i] + (((int32_t)t[i + 1] - t[i]) * (int32_t)frac >> CURVE_TABLE_SHIFT));
+}
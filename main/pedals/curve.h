@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include "esp_err.h"
+#include "calibration.h"
+
+// Curvas de resposta aplicadas sobre a posição calibrada do pedal.
+// Cada curva é compilada em uma tabela normalizada, e a tabela final de
+// 4096 entradas (valor bruto -> eixo) é montada pela calibração.
+
+typedef enum {
+    CURVE_LINEAR = 0,
+    CURVE_GAMMA,   // y = x^gamma
+    CURVE_SCURVE,  // mistura de linear com smoothstep
+    CURVE_SPLINE,  // 5 pontos definidos pelo usuário (Hermite monotônica)
+} curve_type_t;
+
+#define CURVE_SPLINE_POINTS 5
+#define CURVE_SPLINE_MAX    1000 // Escala dos pontos da spline (100,0%)
+
+// Posição normalizada de entrada e saída da curva
+#define CURVE_MAX 65535
+
+typedef struct {
+    uint8_t type;                          // curve_type_t
+    uint8_t scurve;                        // SCURVE: intensidade 0..100
+    uint16_t gamma_x100;                   // GAMMA: expoente * 100 (100 = linear)
+    uint16_t spline[CURVE_SPLINE_POINTS];  // SPLINE: saída em 0, 25, 50, 75 e 100% do curso
+} pedal_curve_t;
+
+// Carrega as curvas da NVS; chamado por calibration_init antes das tabelas
+void curve_init();
+
+void curve_get(pedal_t pedal, pedal_curve_t *out);
+// Recompila a curva, reconstrói só a tabela desse pedal e persiste na NVS
+esp_err_t curve_set(pedal_t pedal, const pedal_curve_t *curve);
+esp_err_t curve_save();
+
+// Posição 0..CURVE_MAX -> saída 0..CURVE_MAX (interpolação inteira)
+uint16_t curve_map(pedal_t pedal, uint32_t pos);
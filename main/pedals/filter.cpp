@@ -0,0 +1,139 @@
+#include "filter.h"
+
+// Padrão: 1€ ajustado para curso completo em ~100 ms (~11000 contagens/s)
+#define DEFAULT_THRESHOLD     2
+#define DEFAULT_EMA_ALPHA     (65536 / 4)
+#define DEFAULT_MIN_CUTOFF    1000  // 1 Hz
+#define DEFAULT_BETA          4     // +4 mHz por contagem/s
+#define DCUTOFF_MHZ           1000  // Corte da derivada do 1€
+
+// 2 * pi em Q16
+#define TWO_PI_Q16 411775
+
+typedef struct {
+    bool primed;
+    uint32_t last_t_us;
+    int32_t y_q16;       // Saída filtrada (EMA / 1€)
+    int32_t dx_q16;      // Derivada filtrada do 1€, contagens/s
+    uint16_t hist[2];    // Mediana de 3
+    uint16_t emitted;    // Último valor que passou pelo gate
+    bool has_emitted;
+} filter_state_t;
+
+static filter_config_t config[PEDAL_COUNT];
+static filter_state_t state[PEDAL_COUNT];
+static filter_stats_t stats[PEDAL_COUNT];
+
+// alpha = 2*pi*fc*Te / (2*pi*fc*Te + 1), em Q16
+static int32_t alpha_q16(uint32_t cutoff_mhz, uint32_t dt_us)
+{
+    int64_t k = (int64_t)TWO_PI_Q16 * cutoff_mhz * dt_us / 1000000000LL;
+    return (int32_t)((k << 16) / (k + 65536));
+}
+
+// Diferença em 64 bits: a derivada do 1€ usa a faixa toda de int32
+static int32_t ema_q16(int32_t y_q16, int32_t x_q16, int32_t alpha)
+{
+    return y_q16 + (int32_t)((((int64_t)x_q16 - y_q16) * alpha) >> 16);
+}
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    if (a > b) { uint16_t t = a; a = b; b = t; }
+    if (b > c) b = c;
+    return a > b ? a : b;
+}
+
+void filter_init()
+{
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        filter_config_t cfg = {};
+        cfg.type = FILTER_ONE_EURO;
+        cfg.threshold = DEFAULT_THRESHOLD;
+        cfg.ema_alpha_q16 = DEFAULT_EMA_ALPHA;
+        cfg.min_cutoff_mhz = DEFAULT_MIN_CUTOFF;
+        cfg.beta_mhz = DEFAULT_BETA;
+        filter_set((pedal_t)i, &cfg);
+    }
+}
+
+void filter_get(pedal_t pedal, filter_config_t *out)
+{
+    if (pedal < PEDAL_COUNT) *out = config[pedal];
+}
+
+void filter_set(pedal_t pedal, const filter_config_t *cfg)
+{
+    if (pedal >= PEDAL_COUNT) return;
+    config[pedal] = *cfg;
+    state[pedal] = {};
+    stats[pedal] = {};
+}
+
+void filter_get_stats(pedal_t pedal, filter_stats_t *out)
+{
+    if (pedal < PEDAL_COUNT) *out = stats[pedal];
+}
+
+bool filter_apply(pedal_t pedal, uint16_t raw, uint32_t t_us, uint16_t *out)
+{
+    const filter_config_t *cfg = &config[pedal];
+    filter_state_t *s = &state[pedal];
+    if (raw >= PEDAL_RAW_RANGE) raw = PEDAL_RAW_RANGE - 1; // Q16 cabe em int32
+    int32_t x_q16 = (int32_t)raw << 16;
+    uint32_t dt_us = t_us - s->last_t_us;
+    if (dt_us == 0) dt_us = 1;
+
+    stats[pedal].samples++;
+
+    uint16_t y;
+    if (!s->primed) {
+        s->primed = true;
+        s->y_q16 = x_q16;
+        s->dx_q16 = 0;
+        s->hist[0] = s->hist[1] = raw;
+        y = raw;
+    } else {
+        switch (cfg->type) {
+            case FILTER_EMA:
+                s->y_q16 = ema_q16(s->y_q16, x_q16, cfg->ema_alpha_q16);
+                break;
+            case FILTER_ONE_EURO: {
+                // Velocidade em contagens/s (Q16), filtrada com corte fixo
+                int64_t dx = ((int64_t)x_q16 - s->y_q16) * 1000000 / dt_us;
+                if (dx > INT32_MAX) dx = INT32_MAX;
+                if (dx < -INT32_MAX) dx = -INT32_MAX;
+                s->dx_q16 = ema_q16(s->dx_q16, (int32_t)dx, alpha_q16(DCUTOFF_MHZ, dt_us));
+
+                uint32_t speed = (uint32_t)((s->dx_q16 < 0 ? -s->dx_q16 : s->dx_q16) >> 16);
+                uint32_t cutoff = cfg->min_cutoff_mhz + cfg->beta_mhz * speed;
+                s->y_q16 = ema_q16(s->y_q16, x_q16, alpha_q16(cutoff, dt_us));
+                break;
+            }
+            case FILTER_MEDIAN3:
+                s->y_q16 = (int32_t)median3(s->hist[0], s->hist[1], raw) << 16;
+                s->hist[0] = s->hist[1];
+                s->hist[1] = raw;
+                break;
+            default:
+                s->y_q16 = x_q16;
+                break;
+        }
+        // Arredonda Q16 -> contagens
+        y = (uint16_t)((s->y_q16 + (1 << 15)) >> 16);
+    }
+    s->last_t_us = t_us;
+
+    // Gate: variação menor que o threshold não gera report
+    if (s->has_emitted) {
+        int32_t diff = (int32_t)y - s->emitted;
+        if (diff < 0) diff = -diff;
+        if (diff < cfg->threshold) return false;
+    }
+
+    s->has_emitted = true;
+    s->emitted = y;
+    stats[pedal].emitted++;
+    *out = y;
+    return true;
+}
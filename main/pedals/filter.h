@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include "calibration.h"
+
+// Filtro de ruído por pedal, aplicado ao valor bruto antes da calibração.
+// Tudo em inteiro, sem alocação; chamado só pela task que alimenta o gamepad.
+
+typedef enum {
+    FILTER_NONE = 0,
+    FILTER_EMA,       // Média móvel exponencial, alpha fixo
+    FILTER_ONE_EURO,  // 1€: corte adaptativo à velocidade do pedal
+    FILTER_MEDIAN3,   // Mediana das 3 últimas amostras
+} filter_type_t;
+
+typedef struct {
+    uint8_t type;              // filter_type_t
+    uint16_t threshold;        // Variação mínima (contagens) para emitir um novo valor
+    uint16_t ema_alpha_q16;    // EMA: peso da amostra nova (65535 = sem filtro)
+    uint32_t min_cutoff_mhz;   // 1€: frequência de corte em repouso (mHz)
+    uint32_t beta_mhz;         // 1€: aumento do corte por contagem/s de velocidade (mHz)
+} filter_config_t;
+
+typedef struct {
+    uint32_t samples;    // Amostras recebidas
+    uint32_t emitted;    // Amostras que passaram pelo gate
+} filter_stats_t;
+
+void filter_init();
+void filter_get(pedal_t pedal, filter_config_t *out);
+void filter_set(pedal_t pedal, const filter_config_t *cfg); // Também zera o estado do filtro
+void filter_get_stats(pedal_t pedal, filter_stats_t *out);
+
+// Filtra uma amostra com timestamp em µs. raw acima de PEDAL_RAW_RANGE - 1
+// (o BLE entrega 16 bits) é saturado. Retorna false quando a saída não
+// mudou além do threshold: nesse caso nada deve ser publicado no gamepad.
+bool filter_apply(pedal_t pedal, uint16_t raw, uint32_t t_us, uint16_t *out);
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Enquadramento COBS dos fluxos binários da CDC (telemetria e captura BLE):
+// cada quadro termina em 0x00 e não contém outro 0x00.
+
+// Tamanho máximo do quadro codificado, com o delimitador
+#define COBS_MAX_LEN(n) ((n) + (n) / 254 + 2)
+
+// Codifica in em out e acrescenta o delimitador; retorna o tamanho do quadro
+static inline size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_pos = 0, o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        } else {
+            out[o++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    out[o++] = 0x00;
+    return o;
+}
+
+// Decodifica um quadro sem o delimitador. Pode ser feito no próprio buffer
+// (out == in). Retorna o tamanho decodificado ou -1 se o quadro for inválido.
+static inline int cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_max)
+{
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return -1;
+        for (uint8_t k = 1; k < code; k++) {
+            if (o >= out_max) return -1;
+            out[o++] = in[i++];
+        }
+        if (code < 0xFF && i < len) {
+            if (o >= out_max) return -1;
+            out[o++] = 0;
+        }
+    }
+    return (int)o;
+}
+
+// CRC-8, polinômio 0x07
+static inline uint8_t cobs_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,198 @@
+#include "telemetry.h"
+#include <atomic>
+#include "usb/gamepad.h"
+#include "usb/cdc.h"
+#include "cobs.h"
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "class/cdc/cdc_device.h"
+}
+
+static const char *TAG = "TELEMETRY";
+
+#define TELEMETRY_TASK_PRIO  2
+#define TELEMETRY_TASK_STACK 3072
+
+// Registros acumulam até completar um pacote bulk (64 bytes) ou até
+// BATCH_MAX_US; assim o FIFO recebe poucas escritas grandes. Um timer one-shot
+// armado no primeiro registro do lote garante o prazo mesmo com taxas abaixo
+// de 1/BATCH_MAX_US, em que o próximo tick chegaria tarde demais.
+#define BATCH_PACKET 64
+#define BATCH_MAX_US 5000
+#define FRAME_MAX COBS_MAX_LEN(TELEMETRY_RECORD_LEN)
+
+static std::atomic<uint16_t> pedal_raw[PEDAL_COUNT];
+static esp_timer_handle_t tick_timer = NULL;
+static esp_timer_handle_t flush_timer = NULL;
+static std::atomic<bool> tick_due{false}; // Distingue o tick do prazo do lote
+static TaskHandle_t task = NULL;
+static std::atomic<bool> running{false};
+static telemetry_stats_t stats = {};
+
+void telemetry_note_pedal(pedal_t pedal, uint16_t raw)
+{
+    if (pedal < PEDAL_COUNT) pedal_raw[pedal].store(raw, std::memory_order_relaxed);
+}
+
+static inline void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static size_t build_frame(uint8_t seq, uint8_t *frame)
+{
+    uint16_t buttons;
+    int16_t axes[GAMEPAD_AXIS_COUNT];
+    uint8_t hat;
+    gamepad_read_state(&buttons, axes, &hat);
+
+    uint8_t rec[TELEMETRY_RECORD_LEN];
+    uint32_t t = (uint32_t)esp_timer_get_time();
+    rec[0] = TELEMETRY_REC_STATE;
+    rec[1] = seq;
+    put16(&rec[2], t & 0xFFFF);
+    put16(&rec[4], t >> 16);
+    put16(&rec[6], buttons);
+    rec[8] = hat;
+    for (int p = 0; p < PEDAL_COUNT; p++) {
+        put16(&rec[9 + 2 * p], pedal_raw[p].load(std::memory_order_relaxed));
+    }
+    for (int a = 0; a < GAMEPAD_AXIS_COUNT; a++) {
+        put16(&rec[15 + 2 * a], (uint16_t)axes[a]);
+    }
+    rec[TELEMETRY_RECORD_LEN - 1] = cobs_crc8(rec, TELEMETRY_RECORD_LEN - 1);
+
+    return cobs_encode(rec, sizeof(rec), frame);
+}
+
+// Nunca bloqueia: sem espaço no FIFO o lote inteiro é descartado,
+// para não cortar quadros no meio
+static void write_batch(const uint8_t *batch, size_t len)
+{
+    if (!tud_cdc_connected() || tud_cdc_write_available() < len) {
+        stats.overruns++;
+        return;
+    }
+    stats.bytes += cdc_write(batch, len);
+    stats.writes++;
+}
+
+// Ticks até o prazo do lote, arredondados para cima (só sem flush_timer)
+static TickType_t batch_wait(size_t batch_len, int64_t batch_start)
+{
+    if (batch_len == 0 || flush_timer) return portMAX_DELAY;
+    int64_t remaining = batch_start + BATCH_MAX_US - esp_timer_get_time();
+    if (remaining <= 0) return 0;
+    return (TickType_t)((remaining + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+}
+
+static void telemetry_task(void *)
+{
+    uint8_t batch[BATCH_PACKET + FRAME_MAX];
+    size_t batch_len = 0;
+    int64_t batch_start = 0;
+    uint8_t seq = 0;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, batch_wait(batch_len, batch_start));
+
+        if (!running.load(std::memory_order_acquire)) {
+            if (flush_timer) esp_timer_stop(flush_timer);
+            tick_due.store(false, std::memory_order_relaxed);
+            batch_len = 0;
+            continue;
+        }
+
+        if (tick_due.exchange(false, std::memory_order_acq_rel)) {
+            if (batch_len == 0) {
+                batch_start = esp_timer_get_time();
+                if (flush_timer) esp_timer_start_once(flush_timer, BATCH_MAX_US);
+            }
+            batch_len += build_frame(seq++, &batch[batch_len]);
+            stats.records++;
+        }
+
+        if (batch_len > 0 &&
+            (batch_len >= BATCH_PACKET || esp_timer_get_time() - batch_start >= BATCH_MAX_US)) {
+            if (flush_timer) esp_timer_stop(flush_timer);
+            write_batch(batch, batch_len);
+            batch_len = 0;
+        }
+    }
+}
+
+static void tick_cb(void *)
+{
+    tick_due.store(true, std::memory_order_release);
+    xTaskNotifyGive(task);
+}
+
+// Prazo do lote parcial: a task confere o tempo e envia o que houver
+static void flush_cb(void *)
+{
+    xTaskNotifyGive(task);
+}
+
+void telemetry_init()
+{
+    xTaskCreate(telemetry_task, "Telemetry", TELEMETRY_TASK_STACK, NULL, TELEMETRY_TASK_PRIO, &task);
+
+    const esp_timer_create_args_t args = {
+        .callback = tick_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "telemetry",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&args, &tick_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao criar timer da telemetria");
+        tick_timer = NULL;
+    }
+
+    const esp_timer_create_args_t flush_args = {
+        .callback = flush_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "telemetry_flush",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&flush_args, &flush_timer) != ESP_OK) {
+        ESP_LOGW(TAG, "Sem timer de prazo do lote, usando ticks");
+        flush_timer = NULL;
+    }
+}
+
+void telemetry_start(uint32_t rate_hz)
+{
+    if (!tick_timer) return;
+    if (rate_hz < 1) rate_hz = 1;
+    if (rate_hz > TELEMETRY_MAX_RATE_HZ) rate_hz = TELEMETRY_MAX_RATE_HZ;
+
+    esp_timer_stop(tick_timer);
+    running.store(true, std::memory_order_release);
+    esp_timer_start_periodic(tick_timer, 1000000 / rate_hz);
+    ESP_LOGI(TAG, "Telemetria a %lu Hz", (unsigned long)rate_hz);
+}
+
+void telemetry_stop()
+{
+    if (!tick_timer) return;
+    esp_timer_stop(tick_timer);
+    running.store(false, std::memory_order_release);
+    xTaskNotifyGive(task); // Descarta o lote parcial
+}
+
+bool telemetry_running()
+{
+    return running.load(std::memory_order_acquire);
+}
+
+// Leitura informativa de outra task
+void telemetry_get_stats(telemetry_stats_t *out)
+{
+    *out = stats;
+}
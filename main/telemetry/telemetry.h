@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include "pedals/calibration.h"
+
+// Telemetria binária pela CDC: registros de estado em quadros COBS
+// (delimitador 0x00) para o decodificador em tools/telemetry_decode.py.
+//
+// Registro (little-endian, TELEMETRY_RECORD_LEN bytes antes do COBS):
+//   [0]      tipo (TELEMETRY_REC_STATE)
+//   [1]      sequência (8 bits, detecta perdas)
+//   [2..5]   timestamp em µs (esp_timer, 32 bits)
+//   [6..7]   máscara de botões
+//   [8]      hat
+//   [9..14]  leitura bruta de cada pedal (ACC, BRK, THT)
+//   [15..28] eixos do gamepad (X, Y, Z, RX, RY, RZ, SLIDER)
+//   [29]     CRC-8 (polinômio 0x07) dos bytes 0..28
+#define TELEMETRY_REC_STATE 0x01
+#define TELEMETRY_RECORD_LEN 30
+#define TELEMETRY_MAX_RATE_HZ 1000
+
+typedef struct {
+    uint32_t records;  // Registros gerados
+    uint32_t bytes;    // Bytes entregues ao FIFO da CDC
+    uint32_t writes;   // Escritas no FIFO (cada uma com um ou mais registros)
+    uint32_t overruns; // Lotes descartados por FIFO cheio ou host desconectado
+} telemetry_stats_t;
+
+void telemetry_init();
+
+// Inicia o envio a rate_hz (1..1000) ou para. Chamável de qualquer task.
+void telemetry_start(uint32_t rate_hz);
+void telemetry_stop();
+bool telemetry_running();
+
+// Última leitura bruta de um pedal (antes do filtro); custo de um store
+void telemetry_note_pedal(pedal_t pedal, uint16_t raw);
+
+void telemetry_get_stats(telemetry_stats_t *out);
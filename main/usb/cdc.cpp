@@ -1,16 +1,123 @@
 #include "cdc.h"
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
 extern "C" {
+#include "esp_timer.h"
 #include "class/cdc/cdc_device.h"
+#include "sdkconfig.h"
 }
 
+#ifdef CONFIG_POLILANTE_CDC_FLUSH_US
+#define CDC_FLUSH_US CONFIG_POLILANTE_CDC_FLUSH_US
+#else
+#define CDC_FLUSH_US 1000
+#endif
+
+#define CDC_PRINTF_MAX 128
+
+// Montagem de quadros: maior quadro aceito, sem o delimitador (cabe um
+// evento de captura BLE com payload máximo em COBS)
+#define CDC_RX_FRAME_MAX 319
+
 static cdc_rx_callback_t user_callback = nullptr;
 
-void cdc_send_text(const char* text)
+// Contexto do TinyUSB apenas; o byte extra guarda o delimitador/terminador
+static uint8_t rx_buf[CDC_RX_FRAME_MAX + 1];
+static size_t rx_len = 0;
+static bool rx_discarding = false; // Descartando o resto de um quadro grande demais
+static char rx_delimiter = '\n';
+static uint32_t rx_frames = 0;
+static uint32_t rx_overflows = 0;
+static uint32_t rx_timeout_us = 0;  // 0: sem prazo (modo linha)
+static cdc_rx_timeout_t rx_on_timeout = nullptr;
+static int64_t rx_frame_us = 0;     // Último quadro entregue ou troca de delimitador
+
+// Nenhum FIFO da CDC usa o modo SPSC do tu_fifo (tu_fifo_set_spsc). O TX tem
+// vários produtores (telemetria, console, dump da captura); o consumidor também
+// não é um contexto só, porque tud_cdc_write_flush lê o FIFO na task que chama
+// (escritor ou timer de flush); e o cdc_device troca o overwritable dele pelo
+// DTR. Já o RX é escrito e lido só na task do TinyUSB, então o mutex de leitura
+// nunca é disputado e o SPSC não ganharia nada.
+static esp_timer_handle_t flush_timer = NULL;
+static std::atomic<bool> flush_armed{false};
+
+// Escritores em várias tasks: contadores atômicos
+static std::atomic<uint32_t> stat_bytes{0};
+static std::atomic<uint32_t> stat_writes{0};
+static std::atomic<uint32_t> stat_flushes{0};
+static std::atomic<uint32_t> stat_packets{0};
+static std::atomic<uint32_t> stat_dropped{0};
+
+static void flush_timer_cb(void*)
+{
+    flush_armed.store(false, std::memory_order_release);
+    cdc_flush();
+}
+
+void cdc_init()
+{
+    tud_cdc_n_set_wanted_char(0, rx_delimiter);
+
+    esp_timer_create_args_t args = {};
+    args.callback = flush_timer_cb;
+    args.name = "cdc_flush";
+    if (esp_timer_create(&args, &flush_timer) != ESP_OK) {
+        flush_timer = NULL;
+    }
+}
+
+// Arma o flush por tempo no primeiro byte pendente depois de um flush
+static void arm_flush()
+{
+    if (!flush_timer) {
+        tud_cdc_write_flush(); // Sem timer: volta ao flush imediato
+        return;
+    }
+    if (!flush_armed.exchange(true, std::memory_order_acq_rel)) {
+        esp_timer_start_once(flush_timer, CDC_FLUSH_US);
+    }
+}
+
+size_t cdc_write(const void* data, size_t len)
 {
-    if (tud_cdc_connected()) {
-        tud_cdc_write_str(text);
-        tud_cdc_write_flush();
+    stat_writes.fetch_add(1, std::memory_order_relaxed);
+    if (!tud_cdc_connected()) {
+        stat_dropped.fetch_add(len, std::memory_order_relaxed);
+        return 0;
     }
+
+    size_t written = tud_cdc_write(data, len);
+    stat_bytes.fetch_add(written, std::memory_order_relaxed);
+    if (written < len) stat_dropped.fetch_add(len - written, std::memory_order_relaxed);
+
+    if (written) arm_flush();
+    return written;
+}
+
+size_t cdc_printf(const char* fmt, ...)
+{
+    char buf[CDC_PRINTF_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (n < 0) return 0;
+    if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1; // Truncado
+    return cdc_write(buf, n);
+}
+
+void cdc_flush()
+{
+    stat_flushes.fetch_add(1, std::memory_order_relaxed);
+    tud_cdc_write_flush();
+}
+
+void cdc_send_text(const char* text)
+{
+    cdc_write(text, strlen(text));
 }
 
 void cdc_set_rx_callback(cdc_rx_callback_t cb)
@@ -18,12 +125,107 @@ void cdc_set_rx_callback(cdc_rx_callback_t cb)
     user_callback = cb;
 }
 
-void cdc_rx_callback()
+void cdc_get_stats(cdc_stats_t* out)
+{
+    out->bytes = stat_bytes.load(std::memory_order_relaxed);
+    out->writes = stat_writes.load(std::memory_order_relaxed);
+    out->flushes = stat_flushes.load(std::memory_order_relaxed);
+    out->packets = stat_packets.load(std::memory_order_relaxed);
+    out->dropped = stat_dropped.load(std::memory_order_relaxed);
+    out->rx_frames = rx_frames;
+    out->rx_overflows = rx_overflows;
+}
+
+// Pode ser chamado de dentro do callback: o resto do buffer já é separado
+// com o novo delimitador (ex.: um comando seguido de quadros COBS)
+void cdc_set_rx_delimiter(char delimiter, uint32_t timeout_us, cdc_rx_timeout_t on_timeout)
+{
+    rx_delimiter = delimiter;
+    rx_timeout_us = delimiter == '\n' ? 0 : timeout_us;
+    rx_on_timeout = on_timeout;
+    rx_frame_us = esp_timer_get_time();
+    tud_cdc_n_set_wanted_char(0, delimiter);
+}
+
+// Modo binário sem quadros no prazo: o que está no buffer e no FIFO é resto
+// do quadro interrompido, descartado até o primeiro '\n'. Retorna true se
+// expirou: o pacote que acabou de chegar já passou pelo wanted_char antigo.
+static bool rx_check_timeout()
 {
-    uint8_t buf[64];
-    uint32_t count = tud_cdc_read(buf, sizeof(buf));
-    
+    if (!rx_timeout_us || esp_timer_get_time() - rx_frame_us <= rx_timeout_us) return false;
+
+    cdc_rx_timeout_t cb = rx_on_timeout;
+    cdc_set_rx_delimiter('\n');
+    rx_len = 0;
+    rx_discarding = true;
+    if (cb) cb();
+    return true;
+}
+
+// Entrega o quadro direto do buffer de montagem, terminado em '\0' no lugar
+// do delimitador (e sem o '\r' final no modo linha)
+static void dispatch(uint8_t *frame, size_t len)
+{
+    if (rx_delimiter == '\n' && len && frame[len - 1] == '\r') len--;
+    frame[len] = '\0';
+    rx_frames++;
+    if (rx_timeout_us) rx_frame_us = esp_timer_get_time();
     if (user_callback) {
-        user_callback(buf, count); // Chama o callback do usuário
+        user_callback(frame, len); // Chama o callback do usuário
     }
-}
\ No newline at end of file
+}
+
+// Esvazia o FIFO de RX, entregando todos os quadros completos
+static void rx_drain()
+{
+    while (true) {
+        if (rx_len == sizeof(rx_buf)) {
+            // Quadro sem delimitador maior que o buffer: descarta até o próximo
+            if (!rx_discarding) rx_overflows++;
+            rx_discarding = true;
+            rx_len = 0;
+        }
+
+        uint32_t n = tud_cdc_n_read(0, &rx_buf[rx_len], sizeof(rx_buf) - rx_len);
+        if (n == 0) break;
+
+        size_t start = 0;
+        size_t end = rx_len + n;
+        uint8_t *p = &rx_buf[rx_len];
+        while ((p = (uint8_t *)memchr(p, rx_delimiter, &rx_buf[end] - p)) != NULL) {
+            size_t pos = p - rx_buf;
+            if (rx_discarding) {
+                rx_discarding = false;
+            } else {
+                dispatch(&rx_buf[start], pos - start);
+            }
+            start = pos + 1;
+            p = &rx_buf[start];
+        }
+
+        rx_len = end - start;
+        if (start && rx_len) memmove(rx_buf, &rx_buf[start], rx_len);
+    }
+}
+
+// Delimitador chegou: caminho normal de entrega
+void cdc_rx_wanted_callback()
+{
+    rx_check_timeout();
+    rx_drain();
+}
+
+// Chamado a cada pacote OUT. Os quadros saem pelo callback do delimitador;
+// aqui só se drena quando o FIFO acumula mais que um quadro sem delimitador.
+void cdc_rx_callback()
+{
+    if (rx_check_timeout() || tud_cdc_n_available(0) >= CDC_RX_FRAME_MAX) {
+        rx_drain();
+    }
+}
+
+// Contexto do TinyUSB: uma transferência IN terminou
+void cdc_tx_complete_callback()
+{
+    stat_packets.fetch_add(1, std::memory_order_relaxed);
+}
@@ -3,14 +3,52 @@
 #include <cstdint>
 #include <cstddef>
 
-// Define o tipo do callback
+// Callback de recepção: um quadro completo por chamada, sem o delimitador,
+// apontando para o buffer interno (terminado em '\0', válido só durante a chamada)
 typedef void (*cdc_rx_callback_t)(const uint8_t* data, size_t len);
 
-// Envia texto
+// Chamado quando o modo binário expira (contexto do TinyUSB)
+typedef void (*cdc_rx_timeout_t)();
+
+// Saída bufferizada: as escritas vão para o FIFO de TX sem flush. O TinyUSB
+// envia sozinho cada pacote completo de 64 bytes; o resto sai no cdc_flush()
+// explícito ou CDC_FLUSH_US depois do primeiro byte pendente.
+typedef struct {
+    uint32_t bytes;    // Bytes aceitos no FIFO
+    uint32_t writes;   // Chamadas de escrita
+    uint32_t flushes;  // Flushes explícitos ou por tempo
+    uint32_t packets;  // Transferências IN concluídas
+    uint32_t dropped;  // Bytes descartados (FIFO cheio ou host desconectado)
+    uint32_t rx_frames;    // Quadros recebidos entregues ao callback
+    uint32_t rx_overflows; // Quadros recebidos descartados por excederem o buffer
+} cdc_stats_t;
+
+void cdc_init(); // Chamado em usb_init
+
+// Nunca bloqueia; retorna quantos bytes couberam no FIFO
+size_t cdc_write(const void* data, size_t len);
+size_t cdc_printf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+void cdc_flush();
+
+// Envia texto (bufferizado, mesmo caminho de cdc_write)
 void cdc_send_text(const char* text);
 
 // Configura o callback do usuário
 void cdc_set_rx_callback(cdc_rx_callback_t cb);
 
+// Delimitador dos quadros recebidos: '\n' (padrão, linhas de texto) ou
+// 0x00 para quadros COBS. Usa o wanted_char do TinyUSB como gatilho.
+// Chamar no contexto do TinyUSB (ex.: de dentro do callback de recepção).
+//
+// Com timeout_us, um delimitador diferente de '\n' só vale enquanto chegam
+// quadros: se o próximo pacote chega mais de timeout_us depois do último
+// quadro, a CDC volta ao modo linha, descarta o quadro parcial até o primeiro
+// '\n' e chama on_timeout. Assim um upload interrompido não deixa os
+// comandos de texto surdos até o reboot.
+void cdc_set_rx_delimiter(char delimiter, uint32_t timeout_us = 0, cdc_rx_timeout_t on_timeout = nullptr);
+
+void cdc_get_stats(cdc_stats_t* out);
 
-void cdc_rx_callback();
\ No newline at end of file
+void cdc_rx_callback();
+void cdc_rx_wanted_callback();
+void cdc_tx_complete_callback();
@@ -1,6 +1,7 @@
 #include "descriptor.h"
 #include "gamepad.h"
 #include "cdc.h"
+#include "haptics/haptics.h"
 extern "C" {
 #include "tinyusb.h"
 #include "esp_log.h"
@@ -8,15 +9,60 @@ extern "C" {
 #include "class/cdc/cdc_device.h"
 }
 
-#define TUSB_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN)
+#define TUSB_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_INOUT_DESC_LEN)
 
+// Gamepad: 16 botões + X/Y/Z/Rx/Ry/Rz/Slider de 16 bits + hat (GAMEPAD_REPORT_LEN bytes)
+// Output: intensidade 0-100 de cada motor de vibração dos pedais (HAPTICS_MOTORS bytes)
 const uint8_t hid_report_descriptor[] = {
-    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0xA1, 0x00,
-    0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00,
-    0x25, 0x01, 0x95, 0x10, 0x75, 0x01, 0x81, 0x02,
-    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32,
-    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03,
-    0x81, 0x02, 0xC0, 0xC0
+    0x05, 0x01,             // USAGE_PAGE (Generic Desktop)
+    0x09, 0x05,             // USAGE (Game Pad)
+    0xA1, 0x01,             // COLLECTION (Application)
+    0xA1, 0x00,             //   COLLECTION (Physical)
+    0x05, 0x09,             //     USAGE_PAGE (Button)
+    0x19, 0x01,             //     USAGE_MINIMUM (Button 1)
+    0x29, 0x10,             //     USAGE_MAXIMUM (Button 16)
+    0x15, 0x00,             //     LOGICAL_MINIMUM (0)
+    0x25, 0x01,             //     LOGICAL_MAXIMUM (1)
+    0x95, 0x10,             //     REPORT_COUNT (16)
+    0x75, 0x01,             //     REPORT_SIZE (1)
+    0x81, 0x02,             //     INPUT (Data,Var,Abs)
+    0x05, 0x01,             //     USAGE_PAGE (Generic Desktop)
+    0x09, 0x30,             //     USAGE (X)
+    0x09, 0x31,             //     USAGE (Y)
+    0x09, 0x32,             //     USAGE (Z)
+    0x09, 0x33,             //     USAGE (Rx)
+    0x09, 0x34,             //     USAGE (Ry)
+    0x09, 0x35,             //     USAGE (Rz)
+    0x09, 0x36,             //     USAGE (Slider)
+    0x16, 0x01, 0x80,       //     LOGICAL_MINIMUM (-32767)
+    0x26, 0xFF, 0x7F,       //     LOGICAL_MAXIMUM (32767)
+    0x75, 0x10,             //     REPORT_SIZE (16)
+    0x95, 0x07,             //     REPORT_COUNT (7)
+    0x81, 0x02,             //     INPUT (Data,Var,Abs)
+    0x09, 0x39,             //     USAGE (Hat switch)
+    0x15, 0x00,             //     LOGICAL_MINIMUM (0)
+    0x25, 0x07,             //     LOGICAL_MAXIMUM (7)
+    0x35, 0x00,             //     PHYSICAL_MINIMUM (0)
+    0x46, 0x3B, 0x01,       //     PHYSICAL_MAXIMUM (315)
+    0x65, 0x14,             //     UNIT (Eng Rot: Degrees)
+    0x75, 0x04,             //     REPORT_SIZE (4)
+    0x95, 0x01,             //     REPORT_COUNT (1)
+    0x81, 0x42,             //     INPUT (Data,Var,Abs,Null)
+    0x65, 0x00,             //     UNIT (None)
+    0x75, 0x04,             //     REPORT_SIZE (4)
+    0x95, 0x01,             //     REPORT_COUNT (1)
+    0x81, 0x03,             //     INPUT (Cnst,Var,Abs) - padding
+    0xC0,                   //   END_COLLECTION
+    0x06, 0x00, 0xFF,       //   USAGE_PAGE (Vendor Defined 0xFF00)
+    0x09, 0x01,             //   USAGE (Haptics: motores dos pedais)
+    0x15, 0x00,             //   LOGICAL_MINIMUM (0)
+    0x25, 0x64,             //   LOGICAL_MAXIMUM (100)
+    0x35, 0x00,             //   PHYSICAL_MINIMUM (0)
+    0x45, 0x00,             //   PHYSICAL_MAXIMUM (0)
+    0x75, 0x08,             //   REPORT_SIZE (8)
+    0x95, HAPTICS_MOTORS,   //   REPORT_COUNT (3)
+    0x91, 0x02,             //   OUTPUT (Data,Var,Abs)
+    0xC0                    // END_COLLECTION
 };
 
 const uint16_t lang_id[] = {0x0409};
@@ -28,10 +74,13 @@ const char* hid_string_descriptor[5] = {
     "Gamepad HID"
 };
 
+#define HID_EP_SIZE 32
+static_assert(GAMEPAD_REPORT_LEN <= HID_EP_SIZE, "report do gamepad maior que o endpoint HID");
+
 const uint8_t hid_configuration_descriptor[] = {
     TUD_CONFIG_DESCRIPTOR(1, 3, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
     TUD_CDC_DESCRIPTOR(0, 0, 0x82, 8, 0x01, 0x83, 64),
-    TUD_HID_DESCRIPTOR(2, 0, false, sizeof(hid_report_descriptor), 0x81, 16, 10)
+    TUD_HID_INOUT_DESCRIPTOR(2, 0, false, sizeof(hid_report_descriptor), 0x02, 0x81, HID_EP_SIZE, HID_POLL_INTERVAL_MS)
 };
 
 // HID callbacks
@@ -41,13 +90,47 @@ extern "C" uint8_t const *tud_hid_descriptor_report_cb(uint8_t) {
 extern "C" uint16_t tud_hid_get_report_cb(uint8_t, uint8_t, hid_report_type_t, uint8_t*, uint16_t) {
     return 0;
 }
-extern "C" void tud_hid_set_report_cb(uint8_t, uint8_t, hid_report_type_t, uint8_t const*, uint16_t) {}
+// Output report (endpoint OUT ou SET_REPORT no EP0): efeitos de vibração do jogo
+extern "C" void tud_hid_set_report_cb(uint8_t, uint8_t, hid_report_type_t report_type,
+                                      uint8_t const* buffer, uint16_t bufsize) {
+    if (report_type == HID_REPORT_TYPE_OUTPUT) {
+        haptics_on_hid_output(buffer, bufsize);
+    }
+}
+
+// Report anterior saiu: envia o estado acumulado desde então (se houver)
+extern "C" void tud_hid_report_complete_cb(uint8_t, uint8_t const*, uint16_t) {
+    gamepad_report_complete();
+}
+
+// SOF (1 ms): despacha mudanças que chegaram com o endpoint ocioso
+extern "C" void tud_sof_cb(uint32_t) {
+    gamepad_flush();
+}
+
+// Device callbacks
+extern "C" void tud_mount_cb(void) {
+    tud_sof_cb_enable(true);
+    gamepad_resend(); // Estado atual para o host
+}
+
+extern "C" void tud_umount_cb(void) {
+    tud_sof_cb_enable(false);
+}
 
 // CDC callback
 extern "C" void tud_cdc_rx_cb(uint8_t) {
     cdc_rx_callback();
 }
 
+extern "C" void tud_cdc_rx_wanted_cb(uint8_t, char) {
+    cdc_rx_wanted_callback();
+}
+
+extern "C" void tud_cdc_tx_complete_cb(uint8_t) {
+    cdc_tx_complete_callback();
+}
+
 void usb_init()
 {
     static const char *TAG = "usb_config";
@@ -65,5 +148,6 @@ void usb_init()
 #endif
     };
     ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
+    cdc_init(); // Depois do driver: o init da classe CDC zera o wanted_char
     ESP_LOGI(TAG, "USB initialization DONE");
 }
\ No newline at end of file
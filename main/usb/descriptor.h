@@ -1,8 +1,19 @@
 #pragma once
 #include <cstdint>
+#include "sdkconfig.h"
+
+// bInterval do endpoint HID IN (ms), escolhido no menuconfig
+#ifdef CONFIG_POLILANTE_HID_POLL_INTERVAL_MS
+#define HID_POLL_INTERVAL_MS CONFIG_POLILANTE_HID_POLL_INTERVAL_MS
+#else
+#define HID_POLL_INTERVAL_MS 1
+#endif
+
+static_assert(HID_POLL_INTERVAL_MS >= 1 && HID_POLL_INTERVAL_MS <= 255,
+              "bInterval full-speed deve estar entre 1 e 255 ms");
 
 extern const uint8_t hid_report_descriptor[];
 extern const char* hid_string_descriptor[5];
 extern const uint8_t hid_configuration_descriptor[];
 
-void usb_init();
\ No newline at end of file
+void usb_init();
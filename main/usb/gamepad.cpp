@@ -1,64 +1,214 @@
 #include "gamepad.h"
+#include "input/latency.h"
+#include <atomic>
 extern "C" {
+#include "esp_timer.h"
 #include "class/hid/hid_device.h"
 }
 
-void gamepad_send_report(uint16_t buttons, int8_t x, int8_t y, int8_t z)
+typedef struct {
+    uint16_t buttons;
+    int16_t axes[GAMEPAD_AXIS_COUNT];
+    uint8_t hat;
+    int64_t stamp_us;   // Início do update que gerou o snapshot
+    int64_t publish_us; // Publicação do snapshot
+} gamepad_state_t;
+
+// Cópia de trabalho, acessada só pelo produtor
+static gamepad_state_t state = { .hat = GAMEPAD_HAT_CENTERED };
+static int update_depth = 0;
+static bool state_dirty = false;
+static int64_t update_start_us = 0;
+
+// Snapshot publicado para o TinyUSB (seqlock: ímpar = escrita em andamento)
+static gamepad_state_t shared = { .hat = GAMEPAD_HAT_CENTERED };
+static std::atomic<uint32_t> shared_seq{0};
+
+// Há snapshot ainda não enviado ao host
+static std::atomic<bool> report_pending{false};
+
+// Report em trânsito, para a latência dos estágios no lado do TinyUSB
+static int64_t inflight_stamp_us = 0;
+static int64_t inflight_submit_us = 0;
+
+static void gamepad_publish()
+{
+    uint32_t seq = shared_seq.load(std::memory_order_relaxed);
+    shared_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    shared = state;
+    shared_seq.store(seq + 2, std::memory_order_release);
+
+    state_dirty = false;
+    report_pending.store(true, std::memory_order_release);
+}
+
+static void gamepad_snapshot(gamepad_state_t *out)
 {
-    uint8_t report[5];
-    report[0] = buttons & 0xFF;
-    report[1] = (buttons >> 8) & 0xFF;
-    report[2] = x;
-    report[3] = y;
-    report[4] = z;
-    tud_hid_report(0, report, sizeof(report));
+    uint32_t seq0, seq1;
+    do {
+        seq0 = shared_seq.load(std::memory_order_acquire);
+        *out = shared;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq1 = shared_seq.load(std::memory_order_relaxed);
+    } while ((seq0 & 1) || seq0 != seq1);
 }
 
-// Estado interno
-static uint16_t buttons = 0;
-static int8_t axis_x = 0, axis_y = 0, axis_z = 0;
+// Publica só se algo mudou e não há update em andamento
+static void gamepad_commit()
+{
+    if (state_dirty && update_depth == 0) {
+        int64_t now = esp_timer_get_time();
+        state.stamp_us = update_start_us ? update_start_us : now;
+        state.publish_us = now;
+        update_start_us = 0;
+        gamepad_publish();
+        latency_record(LATENCY_DECODE, (uint32_t)(now - state.stamp_us));
+    }
+}
 
-void gamepad_init() {
-    buttons = 0;
-    axis_x = axis_y = axis_z = 0;
+// Converte a API de 8 bits para a escala de 16 bits (127 -> 32767)
+static int16_t axis8_to_16(int8_t v)
+{
+    if (v < -127) v = -127;
+    return (int16_t)(v * 258 + v / 127);
+}
+
+void gamepad_send_report(uint16_t buttons, int8_t x, int8_t y, int8_t z)
+{
+    state.buttons = buttons;
+    state.axes[GAMEPAD_AXIS_X] = axis8_to_16(x);
+    state.axes[GAMEPAD_AXIS_Y] = axis8_to_16(y);
+    state.axes[GAMEPAD_AXIS_Z] = axis8_to_16(z);
     gamepad_send();
 }
 
+void gamepad_init() {
+    gamepad_send_report(0, 0, 0, 0);
+}
+
 void gamepad_press(uint8_t button) {
     if (button < 16) {
-        buttons |= (1 << button);
-        gamepad_send();
+        uint16_t buttons = state.buttons | (1 << button);
+        state_dirty |= buttons != state.buttons;
+        state.buttons = buttons;
+        gamepad_commit();
     }
 }
 
 void gamepad_release(uint8_t button) {
     if (button < 16) {
-        buttons &= ~(1 << button);
-        gamepad_send();
+        uint16_t buttons = state.buttons & ~(1 << button);
+        state_dirty |= buttons != state.buttons;
+        state.buttons = buttons;
+        gamepad_commit();
     }
 }
 
+void gamepad_set_buttons(uint16_t pressed, uint16_t changed) {
+    uint16_t buttons = (state.buttons & ~changed) | (pressed & changed);
+    state_dirty |= buttons != state.buttons;
+    state.buttons = buttons;
+    gamepad_commit();
+}
+
+void gamepad_set_hat(uint8_t hat) {
+    if (hat > 7) hat = GAMEPAD_HAT_CENTERED;
+    state_dirty |= hat != state.hat;
+    state.hat = hat;
+    gamepad_commit();
+}
+
+void gamepad_set_axis16(gamepad_axis_t axis, int16_t value) {
+    if (axis >= GAMEPAD_AXIS_COUNT) return;
+    if (value < GAMEPAD_AXIS16_MIN) value = GAMEPAD_AXIS16_MIN;
+    state_dirty |= value != state.axes[axis];
+    state.axes[axis] = value;
+    gamepad_commit();
+}
+
 void gamepad_set_x(int8_t x) {
-    axis_x = x;
-    gamepad_send();
+    gamepad_set_axis16(GAMEPAD_AXIS_X, axis8_to_16(x));
 }
 
 void gamepad_set_y(int8_t y) {
-    axis_y = y;
-    gamepad_send();
+    gamepad_set_axis16(GAMEPAD_AXIS_Y, axis8_to_16(y));
 }
 
 void gamepad_set_z(int8_t z) {
-    axis_z = z;
-    gamepad_send();
+    gamepad_set_axis16(GAMEPAD_AXIS_Z, axis8_to_16(z));
 }
 
+// Força a publicação mesmo sem mudança (ex.: estado inicial no mount)
 void gamepad_send() {
-    uint8_t report[5];
-    report[0] = buttons & 0xFF;
-    report[1] = (buttons >> 8) & 0xFF;
-    report[2] = axis_x;
-    report[3] = axis_y;
-    report[4] = axis_z;
-    tud_hid_report(0, report, sizeof(report));
-}
\ No newline at end of file
+    state_dirty = true;
+    gamepad_commit();
+}
+
+void gamepad_begin_update() {
+    gamepad_begin_update_at(esp_timer_get_time());
+}
+
+void gamepad_begin_update_at(int64_t t_us) {
+    if (update_depth++ == 0) {
+        update_start_us = t_us;
+    }
+}
+
+void gamepad_end_update() {
+    if (update_depth > 0 && --update_depth == 0) {
+        gamepad_commit();
+    }
+}
+
+void gamepad_flush() {
+    if (!report_pending.load(std::memory_order_acquire)) return;
+    if (!tud_hid_ready()) return; // Report anterior ainda em trânsito
+
+    // Limpa antes de ler o snapshot: publicações feitas durante o envio
+    // voltam a marcar pendente e saem no próximo complete/SOF
+    report_pending.store(false, std::memory_order_release);
+
+    gamepad_state_t snap;
+    gamepad_snapshot(&snap);
+
+    uint8_t report[GAMEPAD_REPORT_LEN];
+    report[0] = snap.buttons & 0xFF;
+    report[1] = (snap.buttons >> 8) & 0xFF;
+    for (int i = 0; i < GAMEPAD_AXIS_COUNT; i++) {
+        report[2 + 2 * i] = (uint16_t)snap.axes[i] & 0xFF;
+        report[3 + 2 * i] = ((uint16_t)snap.axes[i] >> 8) & 0xFF;
+    }
+    report[2 + 2 * GAMEPAD_AXIS_COUNT] = snap.hat;
+    if (tud_hid_report(0, report, sizeof(report))) {
+        int64_t now = esp_timer_get_time();
+        latency_record(LATENCY_SCHEDULE, (uint32_t)(now - snap.publish_us));
+        inflight_stamp_us = snap.stamp_us;
+        inflight_submit_us = now;
+    } else {
+        report_pending.store(true, std::memory_order_release);
+    }
+}
+
+void gamepad_report_complete() {
+    if (inflight_stamp_us) {
+        int64_t now = esp_timer_get_time();
+        latency_record(LATENCY_TRANSFER, (uint32_t)(now - inflight_submit_us));
+        latency_record(LATENCY_TOTAL, (uint32_t)(now - inflight_stamp_us));
+        inflight_stamp_us = 0;
+    }
+
+    gamepad_flush();
+}
+
+void gamepad_read_state(uint16_t *buttons, int16_t axes[GAMEPAD_AXIS_COUNT], uint8_t *hat) {
+    gamepad_state_t snap;
+    gamepad_snapshot(&snap);
+    *buttons = snap.buttons;
+    for (int i = 0; i < GAMEPAD_AXIS_COUNT; i++) axes[i] = snap.axes[i];
+    *hat = snap.hat;
+}
+
+void gamepad_resend() {
+    report_pending.store(true, std::memory_order_release);
+}
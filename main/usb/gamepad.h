@@ -1,12 +1,55 @@
 #pragma once
 #include <cstdint>
 
+// Report: 16 botões + 7 eixos de 16 bits (X, Y, Z, Rx, Ry, Rz, Slider) + hat
+typedef enum {
+    GAMEPAD_AXIS_X = 0,
+    GAMEPAD_AXIS_Y,
+    GAMEPAD_AXIS_Z,
+    GAMEPAD_AXIS_RX,
+    GAMEPAD_AXIS_RY,
+    GAMEPAD_AXIS_RZ,
+    GAMEPAD_AXIS_SLIDER,
+    GAMEPAD_AXIS_COUNT
+} gamepad_axis_t;
+
+#define GAMEPAD_AXIS16_MIN (-32767)
+#define GAMEPAD_AXIS16_MAX 32767
+
+// Hat switch: 0-7 = N, NE, L, SE, S, SO, O, NO
+#define GAMEPAD_HAT_CENTERED 0x0F
+
+#define GAMEPAD_REPORT_LEN (2 + 2 * GAMEPAD_AXIS_COUNT + 1)
+
+// O estado é escrito por um único produtor (task do pipeline de entrada) e lido pela
+// task do TinyUSB via seqlock, sem bloqueio dos dois lados.
 void gamepad_send_report(uint16_t buttons, int8_t x, int8_t y, int8_t z);
 
 void gamepad_init();
 void gamepad_press(uint8_t button);
 void gamepad_release(uint8_t button);
+void gamepad_set_buttons(uint16_t pressed, uint16_t changed); // Aplica só os bits de changed
+void gamepad_set_hat(uint8_t hat); // 0-7 ou GAMEPAD_HAT_CENTERED
 void gamepad_set_x(int8_t x); //-127 até 127
 void gamepad_set_y(int8_t y); //-127 até 127
 void gamepad_set_z(int8_t z); //-127 até 127
-void gamepad_send();
\ No newline at end of file
+void gamepad_set_axis16(gamepad_axis_t axis, int16_t value); //-32767 até 32767
+void gamepad_send(); // Publica o estado atual e agenda um report
+
+// Agrupa várias alterações em um único snapshot (ex.: um pacote de pedais).
+// Pode ser aninhado; publica quando o último end é chamado.
+void gamepad_begin_update();
+void gamepad_begin_update_at(int64_t t_us); // Latência medida a partir de t_us (ex.: chegada BLE)
+void gamepad_end_update();
+
+// Chamado em tud_hid_report_complete_cb: registra a latência (input/latency.h) e envia o próximo
+void gamepad_report_complete();
+
+// Chamado no contexto do TinyUSB (SOF / report complete):
+// envia no máximo um report com o estado mais recente se houver mudança pendente
+void gamepad_flush();
+// Lê o último snapshot publicado (qualquer task; ex.: telemetria)
+void gamepad_read_state(uint16_t *buttons, int16_t axes[GAMEPAD_AXIS_COUNT], uint8_t *hat);
+
+// Reenvia o último snapshot publicado (lado do TinyUSB, ex.: no mount)
+void gamepad_resend();
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Ponto de entrada de cada alvo (mesma assinatura do libFuzzer)
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// Inicializa calibração/filtro/curvas na primeira chamada e, a cada entrada,
+// completa o report USB pendente e descarta os já gravados, para o estado dos
+// stubs não crescer durante a execução.
+void fuzz_begin();
+
+// Invariante violada: aborta para o libFuzzer guardar a entrada
+#define FUZZ_ASSERT(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) fuzz_fail(__FILE__, __LINE__, #cond);                       \
+    } while (0)
+
+[[noreturn]] void fuzz_fail(const char *file, int line, const char *expr);
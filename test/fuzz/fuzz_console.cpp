@@ -0,0 +1,16 @@
+// Console da CDC: uma linha arbitrária, terminada em '\0' como a CDC entrega
+// (até o primeiro '\0' da entrada). Comandos que gravam na NVS usam o mapa em
+// memória dos stubs; as linhas impressas têm que caber em cdc_printf.
+#include <vector>
+#include "fuzz.h"
+#include "console/commands.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_begin();
+
+    std::vector<char> line(data, data + size);
+    line.push_back('\0');
+    console_command(line.data());
+    return 0;
+}
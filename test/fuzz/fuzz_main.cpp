@@ -0,0 +1,53 @@
+// Driver sem libFuzzer: executa LLVMFuzzerTestOneInput uma vez para cada
+// arquivo dado (diretórios são percorridos em ordem). Argumentos começando
+// com '-' são ignorados, para a mesma linha de comando servir aos dois.
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "fuzz.h"
+
+namespace fs = std::filesystem;
+
+static bool run_file(const fs::path &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "não abriu %s\n", path.c_str());
+        return false;
+    }
+    // Buffer do tamanho exato: o ASan pega leitura além do fim
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    uint8_t *buf = new uint8_t[data.size()];
+    std::copy(data.begin(), data.end(), buf);
+    LLVMFuzzerTestOneInput(buf, data.size());
+    delete[] buf;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') continue;
+
+        std::vector<fs::path> files;
+        if (fs::is_directory(argv[i])) {
+            for (const auto &entry : fs::directory_iterator(argv[i])) {
+                if (entry.is_regular_file()) files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end());
+        } else {
+            files.push_back(argv[i]);
+        }
+
+        for (const auto &file : files) {
+            if (!run_file(file)) return 2;
+            runs++;
+        }
+    }
+    printf("%d entradas ok\n", runs);
+    return runs ? 0 : 1;
+}
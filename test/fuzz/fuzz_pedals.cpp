@@ -0,0 +1,33 @@
+// Pedais: lote com timestamps e registros legados de pedals_protocol.h e
+// depois o handler completo (filtro, calibração, curva, gamepad).
+#include "fuzz.h"
+#include "ble/pedals_protocol.h"
+#include "input/handlers.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_begin();
+
+    pedals_sample_t samples[PEDALS_BATCH_MAX_SAMPLES];
+    if (pedals_is_batch(data, size)) {
+        // max menor que o lote: não pode escrever além de out[max - 1]
+        size_t max = data[size - 1] % PEDALS_BATCH_MAX_SAMPLES + 1;
+        size_t n = pedals_decode_batch(data, size, samples, max);
+        FUZZ_ASSERT(n <= max);
+        FUZZ_ASSERT(n == max || n == (size - PEDALS_BATCH_HEADER_LEN) / PEDALS_BATCH_SAMPLE_LEN);
+        for (size_t i = 1; i < n; i++) {
+            FUZZ_ASSERT((int32_t)(samples[i].t_us - samples[i - 1].t_us) >= 0);
+        }
+    } else {
+        FUZZ_ASSERT(pedals_decode_batch(data, size, samples, PEDALS_BATCH_MAX_SAMPLES) == 0);
+    }
+
+    pedals_sample_t records[PEDALS_MAX_RECORDS];
+    size_t n = pedals_decode_records(data, size, 1234, records, PEDALS_MAX_RECORDS);
+    FUZZ_ASSERT(n <= PEDALS_MAX_RECORDS);
+    FUZZ_ASSERT(size % PEDALS_RECORD_LEN == 0 || n == 0);
+    for (size_t i = 0; i < n; i++) FUZZ_ASSERT(records[i].t_us == 1234);
+
+    input_pedals(data, size, 0);
+    return 0;
+}
@@ -0,0 +1,24 @@
+// Volante: os dois formatos de steering_protocol.h sobre bytes arbitrários e
+// depois o handler completo (input_steering -> gamepad).
+#include "fuzz.h"
+#include "ble/steering_protocol.h"
+#include "input/handlers.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_begin();
+
+    steering_bin_t out;
+    if (steering_decode_binary(data, size, &out)) {
+        FUZZ_ASSERT(out.has_hat == (size >= STEERING_BIN_HAT_LEN));
+        FUZZ_ASSERT(out.has_hat || out.hat == 0x0F);
+    }
+
+    bool text = steering_decode_text(data, size, &out);
+    FUZZ_ASSERT(text == (out.changed != 0));
+    FUZZ_ASSERT((out.pressed & ~out.changed) == 0); // Só mexe nos botões citados
+    FUZZ_ASSERT(!out.has_hat);
+
+    input_steering(data, size, 0);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Stubs dos módulos que o console usa e que não entram no build do host
+// (CDC, captura, telemetria, motores e BLE), mais o estado comum dos alvos.
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "fuzz.h"
+#include "host_stubs.h"
+#include "usb/cdc.h"
+#include "pedals/filter.h"
+#include "haptics/haptics.h"
+#include "input/capture.h"
+#include "telemetry/telemetry.h"
+#include "ble/ble.h"
+#include "ble/conn_tuning.h"
+
+// Mesmo limite de cdc.cpp: no alvo uma linha maior seria cortada
+#define CDC_PRINTF_MAX 128
+
+void fuzz_fail(const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "%s:%d: %s\n", file, line, expr);
+    abort();
+}
+
+void fuzz_begin()
+{
+    static bool ready = false;
+    if (!ready) {
+        calibration_init();
+        filter_init();
+        ready = true;
+    }
+    host_clock_advance(1000);
+    host_usb_poll();
+    host_reports_clear();
+}
+
+size_t cdc_write(const void *, size_t len) { return len; }
+
+size_t cdc_printf(const char *fmt, ...)
+{
+    char buf[CDC_PRINTF_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    FUZZ_ASSERT(n >= 0 && n < CDC_PRINTF_MAX);
+    return n;
+}
+
+void cdc_send_text(const char *text) { FUZZ_ASSERT(strlen(text) < 256); }
+void cdc_get_stats(cdc_stats_t *out) { memset(out, 0xFF, sizeof(*out)); }
+
+// Contadores no máximo: as linhas do console têm que caber em CDC_PRINTF_MAX
+void haptics_get_stats(haptics_stats_t *out) { memset(out, 0xFF, sizeof(*out)); }
+void ble_get_rx_stats(ble_rx_stats_t *out) { memset(out, 0xFF, sizeof(*out)); }
+
+bool conn_tuning_get_link(int, ble_link_info_t *out)
+{
+    memset(out, 0xFF, sizeof(*out));
+    out->dle_requested = true;
+    return true;
+}
+
+void conn_tuning_log(void) {}
+
+static bool capturing = false;
+static bool loading = false;
+
+void capture_start() { capturing = true; }
+void capture_stop() { capturing = false; }
+void capture_dump() {}
+void capture_load_begin() { loading = true; }
+bool capture_loading() { return loading; }
+void capture_replay(uint32_t) {}
+
+void capture_get_stats(capture_stats_t *out)
+{
+    memset(out, 0xFF, sizeof(*out));
+    out->capturing = capturing;
+    out->replaying = false;
+}
+
+static bool telemetry_on = false;
+
+void telemetry_start(uint32_t) { telemetry_on = true; }
+void telemetry_stop() { telemetry_on = false; }
+bool telemetry_running() { return telemetry_on; }
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+
+// Só o necessário para compilar os módulos: não há escalonador no host,
+// tasks criadas não rodam (host_stubs.h)
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void *TaskHandle_t;
+
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portMAX_DELAY      ((TickType_t)0xFFFFFFFF)
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define pdFAIL  0
@@ -0,0 +1,168 @@
+#include "host_stubs.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include "pedals/calibration.h"
+#include "telemetry/telemetry.h"
+extern "C" {
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "class/hid/hid_device.h"
+}
+
+static int64_t clock_us = 0;
+static std::vector<host_report_t> reports;
+static bool report_inflight = false;
+static uint16_t telemetry_raw[PEDAL_COUNT];
+static int failures = 0;
+
+void host_clock_set(int64_t t_us) { clock_us = t_us; }
+void host_clock_advance(int64_t us) { clock_us += us; }
+
+void host_usb_poll()
+{
+    if (report_inflight) {
+        report_inflight = false;
+        gamepad_report_complete();
+    } else {
+        gamepad_flush();
+    }
+}
+
+const std::vector<host_report_t> &host_reports() { return reports; }
+void host_reports_clear() { reports.clear(); }
+
+uint16_t host_report_buttons(const host_report_t &r)
+{
+    return r.data[0] | (r.data[1] << 8);
+}
+
+int16_t host_report_axis(const host_report_t &r, gamepad_axis_t axis)
+{
+    return (int16_t)(r.data[2 + 2 * axis] | (r.data[3 + 2 * axis] << 8));
+}
+
+uint8_t host_report_hat(const host_report_t &r)
+{
+    return r.data[2 + 2 * GAMEPAD_AXIS_COUNT];
+}
+
+uint16_t host_telemetry_raw(pedal_t pedal) { return telemetry_raw[pedal]; }
+
+void host_fail(const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "%s:%d: falhou: %s\n", file, line, expr);
+    failures++;
+}
+
+void host_fail_eq(const char *file, int line, const char *a, const char *b, long long va, long long vb)
+{
+    fprintf(stderr, "%s:%d: falhou: %s == %s (%lld != %lld)\n", file, line, a, b, va, vb);
+    failures++;
+}
+
+int host_failures() { return failures; }
+
+// Telemetria fica fora do caminho testado: só guarda a leitura bruta
+void telemetry_note_pedal(pedal_t pedal, uint16_t raw)
+{
+    telemetry_raw[pedal] = raw;
+}
+
+extern "C" {
+
+const char *esp_err_to_name(esp_err_t err)
+{
+    return err == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+int64_t esp_timer_get_time(void) { return clock_us; }
+
+// Timers nunca disparam: os módulos testados têm caminho sem timer
+esp_err_t esp_timer_create(const esp_timer_create_args_t *, esp_timer_handle_t *) { return ESP_FAIL; }
+esp_err_t esp_timer_start_once(esp_timer_handle_t, uint64_t) { return ESP_FAIL; }
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t, uint64_t) { return ESP_FAIL; }
+esp_err_t esp_timer_stop(esp_timer_handle_t) { return ESP_FAIL; }
+
+uint32_t esp_cpu_get_cycle_count(void) { return (uint32_t)clock_us; }
+
+static std::map<std::string, std::string> nvs_store;
+static std::vector<std::string> nvs_names;
+
+// Como na NVS real, abrir para leitura um namespace nunca gravado falha
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+    if (mode == NVS_READONLY) {
+        auto it = nvs_store.lower_bound(std::string(name) + "/");
+        if (it == nvs_store.end() || it->first.compare(0, strlen(name) + 1, std::string(name) + "/") != 0) {
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+    nvs_names.push_back(name);
+    *out = (nvs_handle_t)nvs_names.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t len)
+{
+    nvs_store[nvs_names[handle - 1] + "/" + key] = std::string((const char *)value, len);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *len)
+{
+    auto it = nvs_store.find(nvs_names[handle - 1] + "/" + key);
+    if (it == nvs_store.end()) return ESP_ERR_NOT_FOUND;
+    if (out) {
+        if (*len < it->second.size()) return ESP_FAIL;
+        memcpy(out, it->second.data(), it->second.size());
+    }
+    *len = it->second.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t) { return ESP_OK; }
+void nvs_close(nvs_handle_t) {}
+
+// Sem escalonador: tasks de fundo (ex.: gravação da calibração) não rodam
+BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *out)
+{
+    if (out) *out = NULL;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { clock_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000; }
+void vTaskDelete(TaskHandle_t) {}
+TickType_t xTaskGetTickCount(void) { return (TickType_t)(clock_us / 1000 / portTICK_PERIOD_MS); }
+BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int mutex;
+    return &mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+
+bool tud_hid_ready(void) { return !report_inflight; }
+
+bool tud_hid_report(uint8_t, void const *report, uint16_t len)
+{
+    if (report_inflight || len != GAMEPAD_REPORT_LEN) return false;
+    host_report_t r;
+    r.t_us = clock_us;
+    memcpy(r.data, report, len);
+    reports.push_back(r);
+    report_inflight = true;
+    return true;
+}
+
+} // extern "C"
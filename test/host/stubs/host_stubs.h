@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "pedals/calibration.h"
+#include "usb/gamepad.h"
+
+// Controle dos stubs do ESP-IDF/TinyUSB para os testes no host.
+//
+// esp_timer_get_time() devolve um relógio virtual, que só anda quando o
+// teste manda. O lado USB é um host que faz poll a cada host_usb_poll():
+// tud_hid_report() grava o report com o instante virtual do envio e o
+// próximo poll o completa (gamepad_report_complete), como o TinyUSB faria.
+
+typedef struct {
+    int64_t t_us;
+    uint8_t data[GAMEPAD_REPORT_LEN];
+} host_report_t;
+
+void host_clock_set(int64_t t_us);
+void host_clock_advance(int64_t us);
+
+// Um intervalo de poll do host: completa o report em trânsito e envia o próximo
+void host_usb_poll();
+
+const std::vector<host_report_t> &host_reports();
+void host_reports_clear();
+
+// Decodifica um report gravado
+uint16_t host_report_buttons(const host_report_t &r);
+int16_t host_report_axis(const host_report_t &r, gamepad_axis_t axis);
+uint8_t host_report_hat(const host_report_t &r);
+
+// Última leitura bruta entregue à telemetria
+uint16_t host_telemetry_raw(pedal_t pedal);
+
+// Verificação simples: imprime e conta falhas, o main retorna host_failures()
+#define HOST_CHECK(cond)                                                         \
+    do {                                                                         \
+        if (!(cond)) host_fail(__FILE__, __LINE__, #cond);                       \
+    } while (0)
+#define HOST_CHECK_EQ(a, b)                                                      \
+    do {                                                                         \
+        long long va_ = (long long)(a), vb_ = (long long)(b);                    \
+        if (va_ != vb_) host_fail_eq(__FILE__, __LINE__, #a, #b, va_, vb_);      \
+    } while (0)
+
+void host_fail(const char *file, int line, const char *expr);
+void host_fail_eq(const char *file, int line, const char *a, const char *b, long long va, long long vb);
+int host_failures();
@@ -0,0 +1,249 @@
+// Filtro dos pedais com entradas fora do domínio do ADC: o BLE entrega o
+// valor bruto em 16 bits e nada antes do filtro o limita. Roda com UBSan
+// (HOST_SANITIZE), que aborta em overflow de inteiro com sinal.
+//
+// Também reproduz um traço de pedal (traces/pedal_press.csv ou o CSV dado
+// em argv[1], no formato de tools/telemetry_decode.py) em cada tipo de
+// filtro e imprime o jitter em repouso contra o atraso na pisada.
+//
+// Uso: test_filter [traço.csv]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "host_stubs.h"
+#include "input/handlers.h"
+#include "pedals/calibration.h"
+#include "pedals/filter.h"
+
+static void set_type(pedal_t pedal, uint8_t type)
+{
+    filter_config_t cfg;
+    filter_get(pedal, &cfg);
+    cfg.type = type;
+    cfg.threshold = 1; // Sem gate: o valor final é exato
+    filter_set(pedal, &cfg);
+}
+
+// Último valor emitido depois de n amostras iguais, 1 ms entre elas
+static uint16_t settle(pedal_t pedal, uint16_t raw, uint32_t *t_us, int n)
+{
+    uint16_t out = 0, v;
+    for (int i = 0; i < n; i++) {
+        if (filter_apply(pedal, raw, *t_us, &v)) out = v;
+        *t_us += 1000;
+    }
+    return out;
+}
+
+// 0xFFFF em todos os tipos: satura em PEDAL_RAW_RANGE - 1
+static void test_full_scale_raw()
+{
+    const uint8_t types[] = {FILTER_NONE, FILTER_EMA, FILTER_ONE_EURO, FILTER_MEDIAN3};
+    for (uint8_t type : types) {
+        filter_init();
+        set_type(PEDAL_ACC, type);
+
+        uint32_t t = 0;
+        settle(PEDAL_ACC, 0, &t, 3);
+        HOST_CHECK_EQ(settle(PEDAL_ACC, 0xFFFF, &t, 3000), PEDAL_RAW_RANGE - 1);
+        HOST_CHECK_EQ(settle(PEDAL_ACC, 0, &t, 3000), 0);
+    }
+}
+
+// Pisada brusca de um extremo ao outro em 1 ms: a derivada do 1€ satura
+static void test_one_euro_slam()
+{
+    filter_init();
+    set_type(PEDAL_BRK, FILTER_ONE_EURO);
+    uint32_t t = 0;
+    for (int i = 0; i < 200; i++) {
+        settle(PEDAL_BRK, i & 1 ? 0xFFFF : 0, &t, 1);
+        settle(PEDAL_BRK, i & 1 ? 0 : PEDAL_RAW_RANGE - 1, &t, 1);
+    }
+    HOST_CHECK_EQ(settle(PEDAL_BRK, PEDAL_RAW_RANGE - 1, &t, 3000), PEDAL_RAW_RANGE - 1);
+}
+
+// Caminho completo: a telemetria vê o valor bruto, o eixo satura no fim de curso
+static void test_full_scale_report()
+{
+    host_clock_set(0);
+    calibration_init();
+    filter_init();
+
+    const uint8_t p[] = {0x01, 0xFF, 0xFF, 0x02, 0xFF, 0xFF, 0x03, 0x80, 0x00};
+    for (int i = 0; i < 3000; i++) {
+        host_clock_set(i * 1000);
+        input_pedals(p, sizeof(p), i * 1000);
+        host_usb_poll();
+    }
+    host_usb_poll();
+    host_usb_poll();
+
+    HOST_CHECK_EQ(host_telemetry_raw(PEDAL_ACC), 0xFFFF);
+    HOST_CHECK_EQ(host_telemetry_raw(PEDAL_THT), 0x8000);
+
+    const host_report_t &r = host_reports().back();
+    HOST_CHECK_EQ(host_report_axis(r, GAMEPAD_AXIS_X), GAMEPAD_AXIS16_MAX);
+    HOST_CHECK_EQ(host_report_axis(r, GAMEPAD_AXIS_Y), GAMEPAD_AXIS16_MAX);
+    HOST_CHECK_EQ(host_report_axis(r, GAMEPAD_AXIS_Z), GAMEPAD_AXIS16_MAX);
+}
+
+typedef struct {
+    uint32_t t_us;
+    uint16_t raw;
+} trace_sample_t;
+
+// CSV com cabeçalho contendo t_us e acc_raw; linhas com '#' são comentários
+static bool load_trace(const char *path, std::vector<trace_sample_t> *out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+
+    char line[512];
+    int t_col = -1, raw_col = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        std::vector<std::string> cols;
+        for (char *tok = strtok(line, ",\r\n"); tok; tok = strtok(NULL, ",\r\n")) cols.push_back(tok);
+        if (t_col < 0) {
+            for (int i = 0; i < (int)cols.size(); i++) {
+                if (cols[i] == "t_us") t_col = i;
+                if (cols[i] == "acc_raw") raw_col = i;
+            }
+            if (t_col < 0 || raw_col < 0) break;
+            continue;
+        }
+        if ((int)cols.size() <= std::max(t_col, raw_col)) continue;
+        out->push_back({(uint32_t)strtoul(cols[t_col].c_str(), NULL, 10),
+                        (uint16_t)strtoul(cols[raw_col].c_str(), NULL, 10)});
+    }
+    fclose(f);
+    return t_col >= 0 && raw_col >= 0 && !out->empty();
+}
+
+typedef struct {
+    double jitter;     // Desvio padrão da saída em repouso (contagens)
+    double raw_jitter; // O mesmo para o bruto
+    double lag_ms;     // Maior atraso da saída ao cruzar o meio do curso
+} trace_result_t;
+
+// Primeiro índice a partir de from em que v cruza mid na direção dada
+static size_t crossing(const std::vector<uint16_t> &v, size_t from, uint16_t mid, bool rising)
+{
+    for (size_t i = from; i < v.size(); i++) {
+        if (rising ? v[i] >= mid : v[i] < mid) return i;
+    }
+    return v.size();
+}
+
+static double stddev(const std::vector<uint16_t> &v, size_t from, size_t to)
+{
+    double sum = 0, sq = 0;
+    for (size_t i = from; i < to; i++) sum += v[i];
+    double mean = sum / (to - from);
+    for (size_t i = from; i < to; i++) sq += (v[i] - mean) * (v[i] - mean);
+    return std::sqrt(sq / (to - from));
+}
+
+// Passa o traço pelo filtro (configuração padrão, só troca o tipo) e mede a
+// saída publicada: o último valor que passou pelo gate
+static trace_result_t replay_trace(const std::vector<trace_sample_t> &trace, uint8_t type)
+{
+    filter_init();
+    filter_config_t cfg;
+    filter_get(PEDAL_ACC, &cfg);
+    cfg.type = type;
+    filter_set(PEDAL_ACC, &cfg);
+
+    std::vector<uint16_t> raw, out;
+    uint16_t held = trace[0].raw;
+    for (const trace_sample_t &s : trace) {
+        uint16_t v;
+        if (filter_apply(PEDAL_ACC, s.raw, s.t_us, &v)) held = v;
+        raw.push_back(s.raw);
+        out.push_back(held);
+    }
+
+    // Meio do curso entre os percentis 5 e 95 do bruto
+    std::vector<uint16_t> sorted = raw;
+    std::sort(sorted.begin(), sorted.end());
+    uint16_t mid = (sorted[sorted.size() / 20] + sorted[sorted.size() * 19 / 20]) / 2;
+
+    size_t press = crossing(raw, 0, mid, true);
+    size_t release = crossing(raw, press, mid, false);
+    size_t out_press = crossing(out, 0, mid, true);
+    size_t out_release = crossing(out, out_press, mid, false);
+
+    trace_result_t r;
+    // Repouso: depois de 200 ms de acomodação até 100 ms antes da pisada
+    size_t settle = 0, quiet = press;
+    while (settle < press && trace[settle].t_us - trace[0].t_us < 200000) settle++;
+    while (quiet > settle && trace[press].t_us - trace[quiet].t_us < 100000) quiet--;
+    r.jitter = quiet > settle ? stddev(out, settle, quiet) : 0;
+    r.raw_jitter = quiet > settle ? stddev(raw, settle, quiet) : 0;
+
+    if (press >= raw.size() || release >= raw.size() || out_press >= out.size() ||
+        out_release >= out.size()) {
+        r.lag_ms = INFINITY;
+        return r;
+    }
+    double lag_press = (int32_t)(trace[out_press].t_us - trace[press].t_us) / 1000.0;
+    double lag_release = (int32_t)(trace[out_release].t_us - trace[release].t_us) / 1000.0;
+    r.lag_ms = std::max(lag_press, lag_release);
+    return r;
+}
+
+// Jitter contra atraso de cada filtro. Os limites valem para o traço de
+// referência; com outro traço só imprime.
+static void test_trace(const char *path, bool check)
+{
+    std::vector<trace_sample_t> trace;
+    if (!load_trace(path, &trace)) {
+        fprintf(stderr, "não abriu %s\n", path);
+        HOST_CHECK(false);
+        return;
+    }
+
+    static const struct {
+        uint8_t type;
+        const char *name;
+        double max_jitter; // Fração do jitter do bruto
+        double max_lag_ms;
+    } filters[] = {
+        {FILTER_NONE, "nenhum", 1.0, 1.5},
+        {FILTER_EMA, "ema", 0.5, 4.0},
+        {FILTER_ONE_EURO, "1euro", 0.5, 15.0},
+        {FILTER_MEDIAN3, "mediana3", 0.8, 2.5},
+    };
+
+    trace_result_t bare = replay_trace(trace, FILTER_NONE);
+    printf("traço %s: %zu amostras, jitter bruto %.2f\n", path, trace.size(), bare.raw_jitter);
+
+    for (const auto &f : filters) {
+        trace_result_t r = replay_trace(trace, f.type);
+        printf("  %-8s jitter=%.2f lag=%.1f ms\n", f.name, r.jitter, r.lag_ms);
+        if (!check) continue;
+        HOST_CHECK(r.jitter <= f.max_jitter * bare.raw_jitter);
+        HOST_CHECK(r.lag_ms <= f.max_lag_ms);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    test_full_scale_raw();
+    test_one_euro_slam();
+    test_full_scale_report();
+    test_trace(argc > 1 ? argv[1] : HOST_TRACE_DIR "/pedal_press.csv", argc <= 1);
+
+    if (host_failures()) {
+        fprintf(stderr, "%d falha(s)\n", host_failures());
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
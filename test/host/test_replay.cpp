@@ -0,0 +1,331 @@
+// Replay roteirizado da entrada BLE até os reports HID, no host: os handlers
+// de input/, filtro, calibração e gamepad são os mesmos do firmware; o
+// relógio, a NVS e o TinyUSB são stubs (stubs/host_stubs.h). O host USB faz
+// poll a cada 1 ms, como o Windows com bInterval = 1.
+//
+// Uso: test_replay [captura.cap]
+//   Sem argumento roda o roteiro e mede a vazão com um traço sintético; com
+//   uma captura baixada por tools/ble_capture.py dump, reproduz os eventos
+//   dela e imprime a vazão.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "host_stubs.h"
+#include "input/capture.h"
+#include "input/handlers.h"
+#include "input/pipeline.h"
+#include "pedals/calibration.h"
+#include "pedals/curve.h"
+#include "pedals/filter.h"
+#include "telemetry/cobs.h"
+extern "C" {
+#include "ble/pedals_protocol.h"
+#include "ble/steering_protocol.h"
+}
+
+#define POLL_US 1000
+
+typedef struct {
+    int64_t t_us;
+    pipeline_source_t source;
+    std::vector<uint8_t> payload;
+} replay_event_t;
+
+static replay_event_t text(int64_t t_us, const char *s)
+{
+    return {t_us, PIPELINE_SRC_STEERING, std::vector<uint8_t>(s, s + strlen(s))};
+}
+
+static replay_event_t bytes(int64_t t_us, pipeline_source_t source, std::vector<uint8_t> payload)
+{
+    return {t_us, source, payload};
+}
+
+// Registros legados {id, raw_hi, raw_lo}
+static replay_event_t records(int64_t t_us, std::vector<std::pair<uint8_t, uint16_t>> samples)
+{
+    std::vector<uint8_t> p;
+    for (auto &s : samples) {
+        p.push_back(s.first);
+        p.push_back(s.second >> 8);
+        p.push_back(s.second & 0xFF);
+    }
+    return {t_us, PIPELINE_SRC_PEDALS, p};
+}
+
+// Estado inicial conhecido: sem filtro nem gate, calibração padrão
+static void reset(uint8_t filter_type)
+{
+    host_clock_set(0);
+    calibration_init();
+    filter_init();
+    for (int p = 0; p < PEDAL_COUNT; p++) {
+        filter_config_t cfg;
+        filter_get((pedal_t)p, &cfg);
+        cfg.type = filter_type;
+        if (filter_type == FILTER_NONE) cfg.threshold = 1;
+        filter_set((pedal_t)p, &cfg);
+    }
+
+    gamepad_begin_update_at(0);
+    gamepad_set_buttons(0, 0xFFFF);
+    gamepad_set_hat(GAMEPAD_HAT_CENTERED);
+    for (int a = 0; a < GAMEPAD_AXIS_COUNT; a++) gamepad_set_axis16((gamepad_axis_t)a, 0);
+    gamepad_end_update();
+
+    // Report do estado inicial sai e completa antes do roteiro
+    host_usb_poll();
+    host_usb_poll();
+    host_reports_clear();
+}
+
+// Entrega os eventos no instante de cada um, com os polls do host no meio
+static void replay(const std::vector<replay_event_t> &events, int64_t drain_us)
+{
+    int64_t t0 = events.empty() ? 0 : events.front().t_us;
+    int64_t next_poll = t0;
+
+    for (const replay_event_t &ev : events) {
+        while (next_poll <= ev.t_us) {
+            host_clock_set(next_poll);
+            host_usb_poll();
+            next_poll += POLL_US;
+        }
+        host_clock_set(ev.t_us);
+        if (ev.source == PIPELINE_SRC_STEERING) {
+            input_steering(ev.payload.data(), ev.payload.size(), ev.t_us);
+        } else {
+            input_pedals(ev.payload.data(), ev.payload.size(), ev.t_us);
+        }
+    }
+
+    int64_t end = (events.empty() ? t0 : events.back().t_us) + drain_us;
+    for (; next_poll <= end; next_poll += POLL_US) {
+        host_clock_set(next_poll);
+        host_usb_poll();
+    }
+}
+
+static void test_script()
+{
+    reset(FILTER_NONE);
+
+    std::vector<replay_event_t> script = {
+        records(10000, {{1, 1860}, {2, 3000}, {3, 2430}}),
+        text(11500, "b1:1;b3:1"),
+        // Dois pacotes entre polls: só o mais recente vira report
+        records(12200, {{1, 2000}}),
+        records(12400, {{1, 2100}}),
+        // Binário: b1 já pressionado, só o hat muda
+        bytes(14000, PIPELINE_SRC_STEERING, {STEERING_BIN_MAGIC, 0x02, 0x00, 0x02, 0x00, 2}),
+        // Mesmo valor: sem report
+        records(16000, {{1, 2100}}),
+        // Tamanho inválido: descartado
+        bytes(16500, PIPELINE_SRC_PEDALS, {1, 0x08, 0x00, 0x00}),
+        // Lote fora de ordem: o filtro vê 2000 e depois 1900
+        bytes(17000, PIPELINE_SRC_PEDALS, {PEDALS_BATCH_MAGIC, 0x00, 0x01, 0x86, 0xA0,
+                                            2, 0x01, 0xF4, 0x07, 0x6C,   // +500 us: 1900
+                                            2, 0x00, 0x00, 0x07, 0xD0}), // +0 us: 2000
+    };
+
+    input_stats_t before;
+    input_get_stats(&before);
+    replay(script, 5 * POLL_US);
+
+    const std::vector<host_report_t> &r = host_reports();
+    HOST_CHECK_EQ(r.size(), 5);
+    if (r.size() != 5) return;
+
+    // Cada report sai no primeiro poll depois do evento
+    const int64_t sent_at[] = {11000, 12000, 13000, 15000, 18000};
+    for (size_t i = 0; i < r.size(); i++) HOST_CHECK_EQ(r[i].t_us, sent_at[i]);
+
+    HOST_CHECK_EQ(host_report_axis(r[0], GAMEPAD_AXIS_X), GAMEPAD_AXIS16_MIN);
+    HOST_CHECK_EQ(host_report_axis(r[0], GAMEPAD_AXIS_Y), GAMEPAD_AXIS16_MAX);
+    HOST_CHECK(host_report_axis(r[0], GAMEPAD_AXIS_Z) >= -1 && host_report_axis(r[0], GAMEPAD_AXIS_Z) <= 1);
+    HOST_CHECK_EQ(host_report_buttons(r[0]), 0);
+
+    HOST_CHECK_EQ(host_report_buttons(r[1]), 0x000A);
+    HOST_CHECK_EQ(host_report_hat(r[1]), GAMEPAD_HAT_CENTERED);
+
+    HOST_CHECK_EQ(host_report_axis(r[2], GAMEPAD_AXIS_X), calibration_apply(PEDAL_ACC, 2100));
+    HOST_CHECK_EQ(host_report_buttons(r[2]), 0x000A);
+
+    HOST_CHECK_EQ(host_report_hat(r[3]), 2);
+    HOST_CHECK_EQ(host_report_buttons(r[3]), 0x000A);
+
+    HOST_CHECK_EQ(host_report_axis(r[4], GAMEPAD_AXIS_Y), calibration_apply(PEDAL_BRK, 1900));
+    HOST_CHECK_EQ(host_report_axis(r[4], GAMEPAD_AXIS_X), calibration_apply(PEDAL_ACC, 2100));
+
+    input_stats_t after;
+    input_get_stats(&after);
+    HOST_CHECK_EQ(after.pedal_packets - before.pedal_packets, 6);
+    HOST_CHECK_EQ(after.pedal_invalid - before.pedal_invalid, 1);
+    HOST_CHECK_EQ(after.steering_packets - before.steering_packets, 2);
+}
+
+// Vazão do caminho handler -> gamepad -> report, com o filtro padrão (1€).
+// Só conta o tempo de CPU do host: o relógio do firmware é virtual.
+static void print_throughput(const char *name, const std::vector<replay_event_t> &events)
+{
+    auto start = std::chrono::steady_clock::now();
+    replay(events, 10 * POLL_US);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-10s %8zu eventos %8zu reports  %10.0f eventos/s  %6.0f ns/evento\n", name,
+           events.size(), host_reports().size(), events.size() / sec, sec * 1e9 / events.size());
+}
+
+static void test_throughput()
+{
+    reset(FILTER_ONE_EURO);
+
+    // 10 s de pista: lote de 3 pedais a 1 kHz no relógio da unidade, chegando
+    // de 7,5 em 7,5 ms (intervalo de conexão), e um botão a cada 100 ms
+    std::vector<replay_event_t> events;
+    uint32_t unit_us = 0;
+    for (int64_t t = 0; t < 10000000; t += 7500) {
+        std::vector<uint8_t> p = {PEDALS_BATCH_MAGIC, (uint8_t)(unit_us >> 24), (uint8_t)(unit_us >> 16),
+                                  (uint8_t)(unit_us >> 8), (uint8_t)unit_us};
+        for (int k = 0; k < 7; k++) {
+            for (uint8_t id = 1; id <= PEDAL_COUNT; id++) {
+                uint16_t off = k * 1000;
+                uint32_t phase = ((unit_us + off) / 1000 * (3 + id)) % 2280; // Triângulo, ~200 ms por curso
+                uint16_t raw = 1860 + (uint16_t)(phase < 1140 ? phase : 2280 - phase);
+                p.insert(p.end(), {id, (uint8_t)(off >> 8), (uint8_t)off, (uint8_t)(raw >> 8), (uint8_t)raw});
+            }
+        }
+        unit_us += 7000;
+        events.push_back(bytes(t, PIPELINE_SRC_PEDALS, p));
+        if (t % 100000 < 7500) events.push_back(text(t + 1, (t / 100000) % 2 ? "b4:1" : "b4:0"));
+    }
+
+    host_reports_clear();
+    print_throughput("sintético", events);
+
+    for (const host_report_t &r : host_reports()) {
+        for (int a = 0; a < GAMEPAD_AXIS_COUNT; a++) {
+            HOST_CHECK(host_report_axis(r, (gamepad_axis_t)a) >= GAMEPAD_AXIS16_MIN);
+        }
+    }
+    // Um report por poll no máximo, e o host não fica sem report com entrada mudando
+    HOST_CHECK(host_reports().size() <= 10000 + 10);
+    HOST_CHECK(host_reports().size() >= 1300);
+}
+
+// Mapeamento aritmético anterior às tabelas (clamp + regra de 3 + gamma)
+static int16_t __attribute__((noinline)) map_arith(uint16_t raw, float gamma)
+{
+    int32_t v = raw;
+    if (v < CALIBRATION_DEFAULT_MIN) v = CALIBRATION_DEFAULT_MIN;
+    if (v > CALIBRATION_DEFAULT_MAX) v = CALIBRATION_DEFAULT_MAX;
+    float x = (float)(v - CALIBRATION_DEFAULT_MIN) / (CALIBRATION_DEFAULT_MAX - CALIBRATION_DEFAULT_MIN);
+    return (int16_t)(powf(x, gamma) * (GAMEPAD_AXIS16_MAX - GAMEPAD_AXIS16_MIN) + GAMEPAD_AXIS16_MIN);
+}
+
+// Tabela de calibração/curva contra o cálculo direto, com gamma 2,2 e a faixa
+// padrão sem zona morta: mesmo resultado (a menos da interpolação da curva)
+// e o custo por amostra de cada um
+static void test_curve_bench()
+{
+    reset(FILTER_NONE);
+    pedal_calibration_t cal_prev;
+    pedal_curve_t curve_prev;
+    calibration_get(PEDAL_BRK, &cal_prev);
+    curve_get(PEDAL_BRK, &curve_prev);
+
+    pedal_calibration_t cal = {CALIBRATION_DEFAULT_MIN, CALIBRATION_DEFAULT_MAX, 0, 0, false};
+    pedal_curve_t curve = curve_prev;
+    curve.type = CURVE_GAMMA;
+    curve.gamma_x100 = 220;
+    HOST_CHECK_EQ(calibration_set(PEDAL_BRK, &cal), ESP_OK);
+    HOST_CHECK_EQ(curve_set(PEDAL_BRK, &curve), ESP_OK);
+
+    int max_diff = 0;
+    for (int raw = 0; raw < PEDAL_RAW_RANGE; raw++) {
+        int diff = abs(calibration_apply(PEDAL_BRK, raw) - map_arith(raw, 2.2f));
+        if (diff > max_diff) max_diff = diff;
+    }
+
+    // Sequência pseudoaleatória: a tabela não fica inteira no cache L1 por sorte
+    const int samples = 1 << 22;
+    std::vector<uint16_t> raws(samples);
+    uint32_t x = 12345;
+    for (uint16_t &r : raws) {
+        x = x * 1103515245 + 12345;
+        r = (x >> 16) % PEDAL_RAW_RANGE;
+    }
+
+    volatile uint32_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint16_t r : raws) sink = sink + (uint32_t)calibration_apply(PEDAL_BRK, r);
+    auto t1 = std::chrono::steady_clock::now();
+    for (uint16_t r : raws) sink = sink + (uint32_t)map_arith(r, 2.2f);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double lut_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / samples;
+    double arith_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / samples;
+    printf("curva      tabela %.2f ns/amostra, aritmético %.2f ns/amostra, diferença máx %d\n",
+           lut_ns, arith_ns, max_diff);
+    HOST_CHECK(max_diff <= 16); // Interpolação da curva em 65535 contagens
+
+    calibration_set(PEDAL_BRK, &cal_prev);
+    curve_set(PEDAL_BRK, &curve_prev);
+}
+
+// Captura do hub: quadros COBS BEGIN/EVENT.../END (input/capture.h)
+static bool load_capture(const char *path, std::vector<replay_event_t> *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    std::vector<uint8_t> data;
+    int c;
+    while ((c = fgetc(f)) != EOF) data.push_back((uint8_t)c);
+    fclose(f);
+
+    int64_t t = 0;
+    uint32_t last = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] != 0) continue;
+        uint8_t raw[512];
+        int n = cobs_decode(&data[start], i - start, raw, sizeof(raw));
+        start = i + 1;
+        if (n < 6 || raw[0] != CAPTURE_FRAME_EVENT) continue;
+
+        // Timestamps de 32 bits: desenrola para o relógio virtual
+        uint32_t t_us = raw[2] | (raw[3] << 8) | (raw[4] << 16) | ((uint32_t)raw[5] << 24);
+        t = out->empty() ? t_us : t + (uint32_t)(t_us - last);
+        last = t_us;
+        out->push_back({t, (pipeline_source_t)raw[1], std::vector<uint8_t>(raw + 6, raw + n)});
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        std::vector<replay_event_t> events;
+        if (!load_capture(argv[1], &events)) {
+            fprintf(stderr, "não abriu %s\n", argv[1]);
+            return 2;
+        }
+        reset(FILTER_ONE_EURO);
+        print_throughput("captura", events);
+        return 0;
+    }
+
+    test_script();
+    test_throughput();
+    test_curve_bench();
+
+    if (host_failures()) {
+        fprintf(stderr, "%d falha(s)\n", host_failures());
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Captura e replay das escritas BLE do hub (main/input/capture.h).
+
+Uso:
+    ble_capture.py dump /dev/ttyACM0 -o rig.cap        # baixa a captura do hub
+    ble_capture.py show rig.cap                        # lista os eventos
+    ble_capture.py replay /dev/ttyACM0 rig.cap --speed 4 -o novo.txt --ref antigo.txt
+
+No replay a captura é carregada no hub e reproduzida pelo mesmo pipeline de
+decodificação, filtro e mapeamento. O hub devolve o estado do gamepad depois
+de cada evento. Como o pipeline usa os timestamps originais, o resultado não
+depende da velocidade; --ref compara com uma execução anterior (ex.: outro
+firmware) e sai com código 1 se houver diferença.
+
+Antes: "cap on" na serial liga a captura; "cap off" para.
+"""
+import argparse
+import difflib
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from telemetry_decode import cobs_decode  # noqa: E402
+
+FRAME_EVENT = 0x10
+FRAME_BEGIN = 0x11
+FRAME_END = 0x12
+FRAME_STATE = 0x13
+SOURCES = {0: 'steering', 1: 'pedals'}
+STATE = struct.Struct('<BIHB7h')
+
+
+def open_port(path):
+    import serial  # pyserial
+    return serial.Serial(path, timeout=5)
+
+
+def read_frames(port):
+    """Quadros decodificados até FRAME_END (inclusive)."""
+    buf = bytearray()
+    while True:
+        chunk = port.read(max(1, port.in_waiting))
+        if not chunk:
+            raise TimeoutError('sem resposta do hub')
+        buf += chunk
+        while b'\x00' in buf:
+            end = buf.index(b'\x00')
+            frame = cobs_decode(bytes(buf[:end]))
+            del buf[:end + 1]
+            if not frame:
+                continue
+            yield frame
+            if frame[0] == FRAME_END:
+                return
+
+
+def encode_cobs(data):
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_pos] = code
+                code_pos, code = len(out), 1
+                out.append(0)
+    out[code_pos] = code
+    return bytes(out) + b'\x00'
+
+
+def load_capture(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    frames = [cobs_decode(f) for f in data.split(b'\x00') if f]
+    return [f for f in frames if f and f[0] == FRAME_EVENT]
+
+
+def event_fields(frame):
+    source, t_us = struct.unpack_from('<BI', frame, 1)
+    return SOURCES.get(source, source), t_us, frame[6:]
+
+
+def cmd_dump(args):
+    port = open_port(args.port)
+    port.reset_input_buffer()
+    port.write(b'cap dump\n')
+    events = 0
+    with open(args.output, 'wb') as out:
+        for frame in read_frames(port):
+            out.write(encode_cobs(frame))
+            events += frame[0] == FRAME_EVENT
+    print(f'{events} eventos em {args.output}')
+
+
+def cmd_show(args):
+    events = load_capture(args.capture)
+    t0 = None
+    for frame in events:
+        source, t_us, payload = event_fields(frame)
+        t0 = t_us if t0 is None else t0
+        print(f'{(t_us - t0) & 0xFFFFFFFF:>10} us  {source:<8}  {payload.hex(" ")}')
+
+
+def format_state(frame):
+    _, index, buttons, hat, *axes = STATE.unpack(frame)
+    return f'{index} buttons=0x{buttons:04X} hat={hat} axes=' + ','.join(map(str, axes))
+
+
+def cmd_replay(args):
+    events = load_capture(args.capture)
+    port = open_port(args.port)
+    port.reset_input_buffer()
+
+    # Upload: depois de "cap load" a serial aceita quadros COBS até o FRAME_END
+    port.write(b'cap load\n')
+    port.write(encode_cobs(bytes([FRAME_BEGIN, 1]) + struct.pack('<I', len(events))))
+    for frame in events:
+        port.write(encode_cobs(frame))
+    port.write(encode_cobs(bytes([FRAME_END])))
+    reply = port.readline().decode(errors='replace').strip()
+    if reply != f'ok {len(events)}':
+        sys.exit(f'upload falhou: {reply!r}')
+
+    port.write(f'cap replay {args.speed}\n'.encode())
+    states = [format_state(f) for f in read_frames(port) if f[0] == FRAME_STATE]
+    if len(states) != len(events):
+        print(f'# aviso: {len(events)} eventos, {len(states)} estados recebidos', file=sys.stderr)
+
+    text = '\n'.join(states) + '\n'
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+    if args.ref:
+        with open(args.ref) as f:
+            ref = f.read().splitlines()
+        diff = list(difflib.unified_diff(ref, states, args.ref, 'replay', lineterm=''))
+        if diff:
+            print('\n'.join(diff), file=sys.stderr)
+            sys.exit(1)
+        print('# sem diferenças', file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    p = sub.add_parser('dump', help='baixa a captura do hub')
+    p.add_argument('port')
+    p.add_argument('-o', '--output', required=True)
+    p.set_defaults(fn=cmd_dump)
+
+    p = sub.add_parser('show', help='lista os eventos de uma captura')
+    p.add_argument('capture')
+    p.set_defaults(fn=cmd_show)
+
+    p = sub.add_parser('replay', help='reproduz uma captura no hub e compara o resultado')
+    p.add_argument('port')
+    p.add_argument('capture')
+    p.add_argument('--speed', type=int, default=1, help='1 = tempo original, 0 = sem espera')
+    p.add_argument('-o', '--output', help='arquivo com os estados resultantes')
+    p.add_argument('--ref', help='estados de referência para comparar')
+    p.set_defaults(fn=cmd_replay)
+
+    args = parser.parse_args()
+    args.fn(args)
+
+
+if __name__ == '__main__':
+    main()
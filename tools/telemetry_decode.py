@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Decodificador da telemetria binária da CDC (main/telemetry/telemetry.h).
+
+Uso:
+    telemetry_decode.py /dev/ttyACM0 --rate 1000   # liga a telemetria e decodifica
+    telemetry_decode.py captura.bin                 # arquivo gravado da serial
+
+Imprime um CSV por registro. Quadros com CRC ou tamanho inválido (ex.: texto
+de outros comandos misturado ao fluxo) são descartados e contados.
+"""
+import argparse
+import struct
+import sys
+
+REC_STATE = 0x01
+RECORD_LEN = 30
+RECORD = struct.Struct('<BBIHB3H7h')  # sem o CRC final
+AXES = ('x', 'y', 'z', 'rx', 'ry', 'rz', 'slider')
+PEDALS = ('acc_raw', 'brk_raw', 'tht_raw')
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + 1:
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_record(frame):
+    rec = cobs_decode(frame)
+    if rec is None or len(rec) != RECORD_LEN or rec[0] != REC_STATE:
+        return None
+    if crc8(rec[:-1]) != rec[-1]:
+        return None
+    return RECORD.unpack(rec[:-1])
+
+
+def frames(stream):
+    buf = bytearray()
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            end = buf.find(b'\x00')
+            if end < 0:
+                break
+            yield bytes(buf[:end])
+            del buf[:end + 1]
+
+
+def open_source(path, rate):
+    try:
+        import serial  # pyserial
+    except ImportError:
+        serial = None
+
+    if serial is not None and path.startswith(('/dev/', 'COM')):
+        port = serial.Serial(path, timeout=1)
+        if rate:
+            port.write(f'tel {rate}\r\n'.encode())
+        return port
+    return open(path, 'rb')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('source', help='porta serial ou arquivo capturado')
+    parser.add_argument('--rate', type=int, default=0, help='liga a telemetria a N Hz')
+    args = parser.parse_args()
+
+    src = open_source(args.source, args.rate)
+    print('seq,t_us,buttons,hat,' + ','.join(PEDALS) + ',' + ','.join(AXES))
+
+    bad = lost = 0
+    last_seq = None
+    try:
+        for frame in frames(src):
+            fields = decode_record(frame)
+            if fields is None:
+                bad += 1
+                continue
+            _, seq, t_us, buttons, hat, *rest = fields
+            if last_seq is not None:
+                lost += (seq - last_seq - 1) & 0xFF
+            last_seq = seq
+            print(f'{seq},{t_us},0x{buttons:04X},{hat},' + ','.join(str(v) for v in rest))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print(f'# quadros inválidos: {bad}, registros perdidos: {lost}', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()